@@ -13,33 +13,840 @@
 // #define UNTOU3_ENABLE_OPENMP     : enable parallelization of the algorithm based on OpenMP 
 // #define UNTOU3_DISABLE_TCE       : disable tail call elimination in recursive calls
 // #define UNTOU3_DISABLE_UNORDERED : disable the use of a hash table for U(3) weights (binary search tree is used instead)
+// #define UNTOU3_ENABLE_DENSE      : use a dense 2D array indexed by first two labels for U(3) weights (overrides UNTOU3_DISABLE_UNORDERED)
+// #define UNTOU3_ENABLE_FLAT       : use an open-addressing hash table for U(3) weights (overrides UNTOU3_DISABLE_UNORDERED)
 // #define UNTOU3_DISABLE_PRECALC   : disable precalculation of low Gelfand pattern rows to U(3) weights
+// #define UNTOU3_PRECALC_DEPTH d   : number of lowest Gelfand pattern rows that are precalculated (6 by default),
+//                                    which can be changed at runtime by setPrecalcDepth
+// #define UNTOU3_FIXED_MAX_N n     : highest HO level for which untou3_generate_fixed uses UNtoU3Fixed (10 by default)
+// #define UNTOU3_ENABLE_THREADS    : enable parallelization of the algorithm based on executors (see untou3_executor),
+//                                    which is independent of OpenMP and requires linking with a thread library,
+//                                    and asynchronous generation (see generateU3WeightsAsync)
+// #define UNTOU3_ENABLE_OVERFLOW_CHECK : throw std::overflow_error from generation if labels of U(3) weights might not fit
+//                                    into T or their multiplicities into U (see maxLabel and maxMultiplicity)
+// #define UNTOU3_ENABLE_MPI        : enable distribution of generation of U(3) weights over ranks of an MPI communicator
+//                                    (see setCommunicator), which requires compilation and linking by an MPI compiler wrapper
+// #define UNTOU3_ENABLE_OFFLOAD    : generate U(3) weights by the RECURSIVE engine on an OpenMP target device (see setOffload),
+//                                    which requires compilation with OpenMP (and offloading) support; generation falls 
+//                                    back to the host if no device is available
+// #define UNTOU3_ENABLE_CACHE      : enable UNtoU3Cache, which stores generated tables of U(3) weights into files of a cache
+//                                    directory and maps them into memory when they are needed again (requires POSIX)
+// #define UNTOU3_ENABLE_STATS      : collect statistics of generation of U(3) weights by the RECURSIVE engine (see stats),
+//                                    which are not compiled otherwise
+// #define UNTOU3_ENABLE_DOMINANT   : record only U(3) weights in or adjacent to the dominant chamber (f1 + 1 >= f2 and 
+//                                    f2 + 1 >= f3) into tables, which are all the weights read by getLevelDimensionality;
+//                                    the RECURSIVE engine skips subtrees of Gelfand patterns without such weights
+// #define UNTOU3_ENABLE_NUMA       : keep thread-local tables of OpenMP threads on NUMA nodes of their threads and merge them
+//                                    per node first (requires UNTOU3_ENABLE_OPENMP and Linux, threads should be bound
+//                                    to cores, e.g., by OMP_PROC_BIND=close)
 
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <chrono>
 #include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
 #include <vector>
 
+#if defined(UNTOU3_ENABLE_OPENMP) || defined(UNTOU3_ENABLE_OFFLOAD)
+#include <omp.h>
+#endif
+
+#ifdef UNTOU3_ENABLE_THREADS
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <future>
+#include <thread>
+#endif
+
+#ifdef UNTOU3_ENABLE_MPI
+#include <mpi.h>
+#endif
+
+#ifdef UNTOU3_ENABLE_NUMA
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef UNTOU3_ENABLE_CACHE
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifndef UNTOU3_PRECALC_DEPTH
+#define UNTOU3_PRECALC_DEPTH 6
+#endif
+
+#ifndef UNTOU3_FIXED_MAX_N
+#define UNTOU3_FIXED_MAX_N 10
+#endif
+
 #ifndef UNTOU3_DISABLE_UNORDERED
 #include <unordered_map>
-#else 
-#include <map>
 #endif
 
-#ifndef UNTOU3_DISABLE_UNORDERED
-// An auxiliary struct that implements a hasher for an array of 3 numbers
+// An auxiliary struct that implements a hasher for an array of 3 numbers.
+// U(3) weights of a single U(N) irrep have a fixed sum of labels, the third label is thus implied by the first two.
+// These are stored into disjoint halves of the hash value, which makes it collision-free for labels lower than 2^32 
+// (2^16 on platforms with 32-bit std::size_t). The result is multiplied by an odd constant, which keeps it collision-free
+// and distributes weights evenly into buckets of std::unordered_map for any (prime) number of buckets.
 template <typename T>
 struct array_3_hasher
 {
    std::size_t operator()(const std::array<T, 3>& key) const
    {
-      return key[0] + (key[1] << 8) + (key[2] << 16);
+      return ((std::size_t)key[0] ^ ((std::size_t)key[1] << (4 * sizeof(std::size_t)))) * (std::size_t)UINT64_C(0x9E3779B97F4A7C15);
+   }
+};
+
+#ifdef UNTOU3_ENABLE_FLAT
+// An auxiliary class that implements an open-addressing hash table of U(3) weights and their multiplicities.
+// Collisions are resolved by linear probing, the home slot of a key is obtained by Fibonacci hashing of its hash value.
+// The capacity is a power of two, which is doubled whenever the table would become more than half full.
+// Keys with the first label equal to the maximum value of T are reserved for empty slots.
+template <typename T, typename U, typename H = array_3_hasher<T>>
+class array_3_flat_map
+{
+   public:
+      using key_type = std::array<T, 3>;
+      using mapped_type = U;
+      using value_type = std::pair<key_type, U>;
+
+      class const_iterator 
+      {
+         public:
+            const_iterator(const value_type* p, const value_type* end) : p_(p), end_(end) { skip(); }
+
+            const value_type& operator*() const { return *p_; }
+            const value_type* operator->() const { return p_; }
+            const_iterator& operator++() { p_++; skip(); return *this; }
+            bool operator==(const const_iterator& other) const { return p_ == other.p_; }
+            bool operator!=(const const_iterator& other) const { return p_ != other.p_; }
+
+         private:
+            const value_type* p_;
+            const value_type* end_;
+
+            void skip() { while ((p_ != end_) && isEmpty(*p_)) p_++; }
+      };
+
+      U& operator[](const key_type& key)
+      {
+         assert(key[0] != std::numeric_limits<T>::max());
+         if (2 * (size_ + 1) > slots_.size()) 
+            rehash(std::max<size_t>(16, 2 * slots_.size()));
+
+         for (size_t i = home(key); ; i = (i + 1) & mask_) {
+            auto& slot = slots_[i];
+            if (equal(slot.first, key)) return slot.second;
+            if (isEmpty(slot)) {
+               slot.first = key;
+               size_++;
+               used_.push_back(i);
+               return slot.second;
+            }
+         }
+      }
+
+      const_iterator find(const key_type& key) const
+      {
+         if (size_ > 0)
+            for (size_t i = home(key); !isEmpty(slots_[i]); i = (i + 1) & mask_) 
+               if (equal(slots_[i].first, key)) return const_iterator(&slots_[i], slots_.data() + slots_.size());
+         return end();
+      }
+
+      const_iterator begin() const { return const_iterator(slots_.data(), slots_.data() + slots_.size()); }
+      const_iterator end() const { return const_iterator(slots_.data() + slots_.size(), slots_.data() + slots_.size()); }
+
+      // removes all weights, capacity is preserved
+      void clear() 
+      {
+         // only used slots are emptied, such that repeated generation of small tables does not pay for a large capacity
+         for (auto i : used_) slots_[i] = value_type{ emptyKey(), 0 };
+         used_.clear();
+         size_ = 0;
+      }
+
+      // prepares the table for storing n weights without rehashing
+      void reserve(size_t n) 
+      {
+         size_t capacity = 16;
+         while (capacity < 2 * n) capacity *= 2;
+         if (capacity > slots_.size()) rehash(capacity);
+      }
+
+      size_t size() const { return size_; }
+      bool empty() const { return size_ == 0; }
+      size_t capacity() const { return slots_.size(); }
+      float load_factor() const { return slots_.empty() ? 0.0f : (float)size_ / slots_.size(); }
+
+      // number of slots inspected when a given key is searched for
+      size_t probe_length(const key_type& key) const 
+      {
+         if (slots_.empty()) return 0;
+         size_t length = 1;
+         for (size_t i = home(key); !isEmpty(slots_[i]) && !equal(slots_[i].first, key); i = (i + 1) & mask_) 
+            length++;
+         return length;
+      }
+
+   private:
+      std::vector<value_type> slots_;
+      size_t size_ = 0;
+      size_t mask_ = 0;
+      unsigned shift_ = 64;
+      // positions of used slots
+      std::vector<size_t> used_;
+
+      static key_type emptyKey() 
+      {
+         const T e = std::numeric_limits<T>::max();
+         return { e, e, e };
+      }
+      static bool isEmpty(const value_type& slot) { return slot.first[0] == std::numeric_limits<T>::max(); }
+      // (std::array comparison may end up in a call of memcmp)
+      static bool equal(const key_type& a, const key_type& b) { return (a[0] == b[0]) && (a[1] == b[1]) && (a[2] == b[2]); }
+
+      size_t home(const key_type& key) const 
+      {
+         return (size_t)(((uint64_t)H{}(key) * UINT64_C(0x9E3779B97F4A7C15)) >> shift_);
+      }
+
+      void rehash(size_t capacity)
+      {
+         std::vector<value_type> previous;
+         previous.swap(slots_);
+         slots_.assign(capacity, value_type{ emptyKey(), 0 });
+         mask_ = capacity - 1;
+         shift_ = 64;
+         while (capacity > 1) { capacity /= 2; shift_--; }
+
+         used_.clear();
+         for (const auto& slot : previous) 
+            if (!isEmpty(slot)) {
+               size_t i = home(slot.first);
+               while (!isEmpty(slots_[i])) i = (i + 1) & mask_;
+               slots_[i] = slot;
+               used_.push_back(i);
+            }
+      }
+};
+#endif /* UNTOU3_ENABLE_FLAT */
+
+#ifdef UNTOU3_ENABLE_DENSE
+// An auxiliary class that implements a table of U(3) weights and their multiplicities stored in a dense 2D array.
+// All stored weights need to have the same sum of labels, therefore the array is indexed only by the first two labels.
+// Bounds of labels are specified by reshape, which needs to be called before any weight is accessed.
+// Iteration visits only weights with nonzero multiplicities in the lexicographical order of labels
+// and the provided key/value pairs are temporaries.
+template <typename T, typename U>
+class array_3_dense_map
+{
+   public:
+      using key_type = std::array<T, 3>;
+      using mapped_type = U;
+      using value_type = std::pair<key_type, U>;
+
+      class const_iterator 
+      {
+         public:
+            struct pointer {
+               value_type value;
+               const value_type* operator->() const { return &value; }
+            };
+
+            const_iterator(const array_3_dense_map* map, size_t pos) : map_(map), pos_(pos) { skip(); }
+
+            value_type operator*() const { return { map_->key(pos_), map_->data_[pos_] }; }
+            pointer operator->() const { return { **this }; }
+            const_iterator& operator++() { pos_++; skip(); return *this; }
+            bool operator==(const const_iterator& other) const { return pos_ == other.pos_; }
+            bool operator!=(const const_iterator& other) const { return pos_ != other.pos_; }
+
+         private:
+            const array_3_dense_map* map_;
+            size_t pos_;
+
+            void skip() { while ((pos_ < map_->data_.size()) && (map_->data_[pos_] == 0)) pos_++; }
+      };
+
+      // Sets bounds lo and hi of labels of stored weights, where sum is the sum of their labels.
+      // Multiplicities of all weights are set to zero (allocated memory is reused).
+      void reshape(const key_type& lo, const key_type& hi, T sum)
+      {
+         lo_ = lo; hi_ = hi; sum_ = sum;
+         stride_ = hi[1] - lo[1] + 1;
+         data_.assign((hi[0] - lo[0] + 1) * stride_, 0);
+      }
+
+      // sets multiplicities of all weights to zero
+      void clear() { std::fill(data_.begin(), data_.end(), 0); }
+
+      // Adds multiplicities of other (which needs to have the same bounds) stored at positions [begin, end)
+      // of the underlying array.
+      void merge(const array_3_dense_map& other, size_t begin, size_t end) 
+      {
+         assert(other.data_.size() == data_.size());
+         for (size_t pos = begin; pos < end; pos++) data_[pos] += other.data_[pos];
+      }
+
+      // the key needs to lie within bounds
+      U& operator[](const key_type& key) 
+      {
+         assert(contains(key));
+         return data_[index(key)];
+      }
+
+      const_iterator find(const key_type& key) const 
+      {
+         if (!contains(key)) return end();
+         auto pos = index(key);
+         return data_[pos] ? const_iterator(this, pos) : end();
+      }
+
+      const_iterator begin() const { return const_iterator(this, 0); }
+      const_iterator end() const { return const_iterator(this, data_.size()); }
+
+      // number of weights with nonzero multiplicities (requires a pass over the whole array)
+      size_t size() const { return data_.size() - std::count(data_.begin(), data_.end(), 0); }
+      bool empty() const { return begin() == end(); }
+      // number of entries of the underlying array
+      size_t length() const { return data_.size(); }
+      // the underlying array, where weights with the same first label form rows of stride() entries
+      const U* data() const { return data_.data(); }
+      U* data() { return data_.data(); }
+      size_t stride() const { return stride_; }
+      // bounds of labels and their sum
+      const key_type& lo() const { return lo_; }
+      const key_type& hi() const { return hi_; }
+      T sum() const { return sum_; }
+
+      // position of a key within the underlying array
+      size_t index(const key_type& key) const { return (key[0] - lo_[0]) * stride_ + (key[1] - lo_[1]); }
+      // the same for a key that may lie below bounds, such that a position of its shifted key is offset(key) + offset(shift)
+      std::ptrdiff_t offset(const key_type& key) const 
+      {
+         return ((std::ptrdiff_t)key[0] - (std::ptrdiff_t)lo_[0]) * (std::ptrdiff_t)stride_ + ((std::ptrdiff_t)key[1] - (std::ptrdiff_t)lo_[1]);
+      }
+      // key at a given position within the underlying array
+      key_type key(size_t pos) const 
+      {
+         T l0 = lo_[0] + pos / stride_, l1 = lo_[1] + pos % stride_;
+         return { l0, l1, (T)(sum_ - l0 - l1) };
+      }
+
+      bool contains(const key_type& key) const 
+      {
+         for (int i = 0; i < 3; i++)
+            if ((key[i] < lo_[i]) || (key[i] > hi_[i])) return false;
+         return key[0] + key[1] + key[2] == sum_;
+      }
+
+   private:
+      key_type lo_{}, hi_{};
+      T sum_ = 0;
+      size_t stride_ = 0;
+      std::vector<U> data_;
+};
+#endif /* UNTOU3_ENABLE_DENSE */
+
+#ifdef UNTOU3_ENABLE_CACHE
+// Header of files with tables of U(3) weights written by array_3_mapped_table::write. It is followed (at offset data_offset)
+// by count entries of labels and multiplicities of U(3) weights sorted lexicographically by labels. Files are written
+// in the native byte order and sizes of types, which are recorded in the header and checked when files are mapped.
+struct untou3_cache_header
+{
+   enum : uint32_t { current_version = 1, byte_order_mark = 0x01020304, data_offset = 64 };
+
+   char magic[8];       // "UNTOU3W" terminated by zero
+   uint32_t version;    // current_version
+   uint32_t byte_order; // byte_order_mark
+   uint32_t label_size; // sizes of labels, multiplicities, and entries in bytes
+   uint32_t mult_size;
+   uint32_t entry_size;
+   int32_t n;           // HO level and the input U(N) irrep of the table
+   uint16_t n2, n1, n0;
+   uint16_t reserved;
+   uint64_t count;      // number of entries
+
+   static const char* signature() { return "UNTOU3W"; }
+};
+
+// An auxiliary class that implements a read-only table of U(3) weights and their multiplicities mapped from a file 
+// (see untou3_cache_header), which is shared by all processes of a node that map the same file. Lookups are binary searches
+// over the sorted entries, iteration visits weights in the lexicographical order and the provided key/value pairs are temporaries.
+template <typename T, typename U>
+class array_3_mapped_table
+{
+   public:
+      using key_type = std::array<T, 3>;
+      using mapped_type = U;
+      using value_type = std::pair<key_type, U>;
+
+      // layout of entries in files
+      struct entry {
+         key_type key;
+         U value;
+      };
+
+      class const_iterator 
+      {
+         public:
+            struct pointer {
+               value_type value;
+               const value_type* operator->() const { return &value; }
+            };
+
+            explicit const_iterator(const entry* p) : p_(p) { }
+
+            value_type operator*() const { return { p_->key, p_->value }; }
+            pointer operator->() const { return { **this }; }
+            const_iterator& operator++() { p_++; return *this; }
+            bool operator==(const const_iterator& other) const { return p_ == other.p_; }
+            bool operator!=(const const_iterator& other) const { return p_ != other.p_; }
+
+         private:
+            const entry* p_;
+      };
+
+      array_3_mapped_table() = default;
+      array_3_mapped_table(const array_3_mapped_table&) = delete;
+      array_3_mapped_table& operator=(const array_3_mapped_table&) = delete;
+      array_3_mapped_table(array_3_mapped_table&& other) { swap(other); }
+      array_3_mapped_table& operator=(array_3_mapped_table&& other) { swap(other); return *this; }
+      ~array_3_mapped_table() { unmap(); }
+
+      // Maps a file that needs to contain the table of the U(N) irrep specified by n2, n1, and n0 of the HO level n
+      // with labels of type T and multiplicities of type U. Returns false if the file cannot be mapped or its header
+      // does not match, the table is then empty.
+      bool map(const std::string& path, int n, uint16_t n2, uint16_t n1, uint16_t n0);
+
+      // unmaps the file, the table is then empty
+      void unmap()
+      {
+         if (addr_) munmap(addr_, length_);
+         addr_ = nullptr; length_ = 0; data_ = nullptr; size_ = 0;
+      }
+
+      // Writes weights with nonzero multiplicities of a table (of any type that can be iterated over) into a file 
+      // that can be mapped by map. The file is written under a temporary name first and then renamed, therefore
+      // concurrent writers of the same file (e.g., jobs sharing a cache directory) do not corrupt it.
+      // Throws std::runtime_error if the file cannot be written.
+      template <typename Table>
+      static void write(const std::string& path, int n, uint16_t n2, uint16_t n1, uint16_t n0, const Table& table);
+
+      const_iterator find(const key_type& key) const
+      {
+         auto p = std::lower_bound(data_, data_ + size_, key, [](const entry& e, const key_type& k) { return e.key < k; });
+         return ((p != data_ + size_) && (p->key == key)) ? const_iterator(p) : end();
+      }
+
+      const_iterator begin() const { return const_iterator(data_); }
+      const_iterator end() const { return const_iterator(data_ + size_); }
+
+      size_t size() const { return size_; }
+      bool empty() const { return size_ == 0; }
+      // the sorted entries
+      const entry* data() const { return data_; }
+
+      void swap(array_3_mapped_table& other)
+      {
+         std::swap(addr_, other.addr_); std::swap(length_, other.length_);
+         std::swap(data_, other.data_); std::swap(size_, other.size_);
+      }
+
+   private:
+      void* addr_ = nullptr;
+      size_t length_ = 0;
+      const entry* data_ = nullptr;
+      size_t size_ = 0;
+};
+
+template <typename T, typename U>
+bool array_3_mapped_table<T, U>::map(const std::string& path, int n, uint16_t n2, uint16_t n1, uint16_t n0)
+{
+   unmap();
+
+   int fd = open(path.c_str(), O_RDONLY);
+   if (fd < 0) return false;
+   struct stat st;
+   void* addr = MAP_FAILED;
+   if ((fstat(fd, &st) == 0) && (st.st_size >= (off_t)untou3_cache_header::data_offset))
+      addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+   close(fd);
+   if (addr == MAP_FAILED) return false;
+
+   const auto& h = *static_cast<const untou3_cache_header*>(addr);
+   const size_t length = st.st_size, bytes = length - untou3_cache_header::data_offset;
+   bool valid = (std::memcmp(h.magic, untou3_cache_header::signature(), sizeof(h.magic)) == 0)
+      && (h.version == untou3_cache_header::current_version) && (h.byte_order == untou3_cache_header::byte_order_mark)
+      && (h.label_size == sizeof(T)) && (h.mult_size == sizeof(U)) && (h.entry_size == sizeof(entry))
+      && (h.n == n) && (h.n2 == n2) && (h.n1 == n1) && (h.n0 == n0)
+      && (bytes % sizeof(entry) == 0) && (h.count == bytes / sizeof(entry));
+   if (!valid) {
+      munmap(addr, length);
+      return false;
+   }
+
+   addr_ = addr;
+   length_ = length;
+   data_ = reinterpret_cast<const entry*>(static_cast<const char*>(addr) + untou3_cache_header::data_offset);
+   size_ = h.count;
+   return true;
+}
+
+template <typename T, typename U>
+template <typename Table>
+void array_3_mapped_table<T, U>::write(const std::string& path, int n, uint16_t n2, uint16_t n1, uint16_t n0, const Table& table)
+{
+   std::vector<value_type> pairs;
+   for (const auto& pair : table)
+      if (pair.second) pairs.emplace_back(pair.first, pair.second);
+   std::sort(pairs.begin(), pairs.end(), [](const value_type& a, const value_type& b) { return a.first < b.first; });
+
+   // padding bytes of entries are zeroed, so that files of the same table are identical
+   std::vector<entry> entries(pairs.size());
+   for (size_t i = 0; i < pairs.size(); i++) {
+      std::memset(&entries[i], 0, sizeof(entry));
+      entries[i].key = pairs[i].first;
+      entries[i].value = pairs[i].second;
+   }
+
+   static_assert(sizeof(untou3_cache_header) <= untou3_cache_header::data_offset, "header does not fit");
+   untou3_cache_header h;
+   std::memset(&h, 0, sizeof(h));
+   std::memcpy(h.magic, untou3_cache_header::signature(), sizeof(h.magic));
+   h.version = untou3_cache_header::current_version;
+   h.byte_order = untou3_cache_header::byte_order_mark;
+   h.label_size = sizeof(T);
+   h.mult_size = sizeof(U);
+   h.entry_size = sizeof(entry);
+   h.n = n; h.n2 = n2; h.n1 = n1; h.n0 = n0;
+   h.count = entries.size();
+   char buffer[untou3_cache_header::data_offset] = { };
+   std::memcpy(buffer, &h, sizeof(h));
+
+   // the temporary name is unique among processes of all nodes
+   char host[256] = { };
+   gethostname(host, sizeof(host) - 1);
+   const std::string tmp = path + ".tmp." + host + "." + std::to_string(getpid());
+
+   std::FILE* file = std::fopen(tmp.c_str(), "wb");
+   if (!file) throw std::runtime_error("array_3_mapped_table: cannot create file " + tmp);
+   bool ok = (std::fwrite(buffer, sizeof(buffer), 1, file) == 1);
+   if (ok && !entries.empty()) ok = (std::fwrite(entries.data(), sizeof(entry), entries.size(), file) == entries.size());
+   ok = (std::fclose(file) == 0) && ok;
+   if (ok) ok = (std::rename(tmp.c_str(), path.c_str()) == 0);
+   if (!ok) {
+      std::remove(tmp.c_str());
+      throw std::runtime_error("array_3_mapped_table: cannot write file " + path);
+   }
+}
+#endif /* UNTOU3_ENABLE_CACHE */
+
+// An auxiliary class of nonnegative integers of arbitrary size stored as 32-bit limbs (the least significant first),
+// which supports only operations needed for exact verification of level dimensionalities (see UNtoU3::validate).
+class untou3_bigint
+{
+   public:
+      untou3_bigint(uint64_t value = 0) : untou3_bigint(from(value)) { }
+
+      // value of an unsigned integer type of any width (e.g., untou3_uint128)
+      template <typename V>
+      static untou3_bigint from(V value)
+      {
+         untou3_bigint result{ std::vector<uint32_t>{} };
+         for (; value; value = (V)(value >> 16 >> 16)) 
+            result.limbs_.push_back((uint32_t)value);
+         return result;
+      }
+
+      untou3_bigint& operator+=(const untou3_bigint& other)
+      {
+         if (limbs_.size() < other.limbs_.size()) 
+            limbs_.resize(other.limbs_.size(), 0);
+         uint64_t carry = 0;
+         for (size_t i = 0; i < limbs_.size(); i++) {
+            carry += (uint64_t)limbs_[i] + ((i < other.limbs_.size()) ? other.limbs_[i] : 0);
+            limbs_[i] = (uint32_t)carry;
+            carry >>= 32;
+         }
+         if (carry) limbs_.push_back((uint32_t)carry);
+         return *this;
+      }
+
+      // multiplies the number by m
+      untou3_bigint& multiply(uint64_t m)
+      {
+         if (m >> 32) {
+            untou3_bigint high = *this;
+            high.multiplyLimb((uint32_t)(m >> 32));
+            if (!high.limbs_.empty()) high.limbs_.insert(high.limbs_.begin(), 0);
+            multiplyLimb((uint32_t)m);
+            return *this += high;
+         }
+         multiplyLimb((uint32_t)m);
+         return *this;
+      }
+
+      // divides the number by a nonzero d and returns the remainder
+      uint32_t divide(uint32_t d)
+      {
+         assert(d);
+         uint64_t rem = 0;
+         for (size_t i = limbs_.size(); i-- > 0; ) {
+            rem = (rem << 32) | limbs_[i];
+            limbs_[i] = (uint32_t)(rem / d);
+            rem %= d;
+         }
+         trim();
+         return (uint32_t)rem;
+      }
+
+      bool operator==(const untou3_bigint& other) const { return limbs_ == other.limbs_; }
+      bool operator!=(const untou3_bigint& other) const { return limbs_ != other.limbs_; }
+
+      // decimal representation
+      std::string str() const
+      {
+         untou3_bigint temp = *this;
+         std::string digits;
+         do {
+            uint32_t chunk = temp.divide(1000000000);
+            for (int i = 0; i < 9; i++, chunk /= 10) digits.push_back((char)('0' + chunk % 10));
+         } while (!temp.limbs_.empty());
+         while ((digits.size() > 1) && (digits.back() == '0')) digits.pop_back();
+         return std::string(digits.rbegin(), digits.rend());
+      }
+
+      friend std::ostream& operator<<(std::ostream& os, const untou3_bigint& value) { return os << value.str(); }
+
+   private:
+      // (no leading zero limbs, zero has no limbs)
+      std::vector<uint32_t> limbs_;
+
+      explicit untou3_bigint(std::vector<uint32_t> limbs) : limbs_(std::move(limbs)) { }
+
+      void multiplyLimb(uint32_t m)
+      {
+         uint64_t carry = 0;
+         for (auto& limb : limbs_) {
+            carry += (uint64_t)limb * m;
+            limb = (uint32_t)carry;
+            carry >>= 32;
+         }
+         if (carry) limbs_.push_back((uint32_t)carry);
+         trim();
+      }
+
+      void trim() { while (!limbs_.empty() && (limbs_.back() == 0)) limbs_.pop_back(); }
+};
+
+#ifdef UNTOU3_ENABLE_THREADS
+// Interface of executors used by UNtoU3 for parallel generation of U(3) weights instead of OpenMP.
+// Applications that run their own thread pools (TBB, std::thread-based) can implement it with these pools, e.g.:
+//
+//    struct tbb_executor : untou3_executor {
+//       size_t concurrency() const override { return tbb::this_task_arena::max_concurrency(); }
+//       void parallel(const std::function<void(size_t)>& body) override { tbb::parallel_for(size_t(0), concurrency(), body); }
+//    };
+class untou3_executor
+{
+   public:
+      virtual ~untou3_executor() { }
+
+      // number of workers
+      virtual size_t concurrency() const = 0;
+
+      // Calls body(w) once for each worker w = 0, ..., concurrency()-1 and returns after all calls finished. 
+      // The calls may, but do not need to, run concurrently; body never waits for other calls to start.
+      virtual void parallel(const std::function<void(size_t)>& body) = 0;
+};
+
+// Executor that runs workers by new std::threads, the calling thread runs worker 0.
+class untou3_thread_executor : public untou3_executor
+{
+   public:
+      explicit untou3_thread_executor(size_t threads = std::thread::hardware_concurrency()) 
+         : threads_(std::max<size_t>(threads, 1)) { }
+
+      size_t concurrency() const override { return threads_; }
+
+      void parallel(const std::function<void(size_t)>& body) override
+      {
+         // an exception thrown by a worker is rethrown by the calling thread
+         std::vector<std::exception_ptr> errors(threads_);
+         auto run = [&](size_t w) {
+            try { body(w); }
+            catch (...) { errors[w] = std::current_exception(); }
+         };
+
+         std::vector<std::thread> threads;
+         for (size_t w = 1; w < threads_; w++) 
+            threads.emplace_back(run, w);
+         run(0);
+         for (auto& t : threads) 
+            t.join();
+
+         for (auto& e : errors) 
+            if (e) std::rethrow_exception(e);
+      }
+
+   private:
+      size_t threads_;
+};
+
+// Exception thrown by untou3_future::get if generation was cancelled.
+struct untou3_cancelled : std::runtime_error
+{
+   untou3_cancelled() : std::runtime_error("generation of U(3) weights cancelled") { }
+};
+
+// Handle of a table of U(3) weights generated asynchronously (see UNtoU3::generateU3WeightsAsync).
+// Destruction of the handle waits until generation finishes, cancel thus needs to be called first to stop it early.
+template <typename Table>
+class untou3_future
+{
+   public:
+      untou3_future() = default;
+      untou3_future(std::future<const Table*> future, std::shared_ptr<std::atomic<bool>> cancelled) 
+         : future_(std::move(future)), cancelled_(std::move(cancelled)) { }
+
+      // Waits until generation finishes and returns the table, which is owned by the generator.
+      // Rethrows an exception thrown by generation (untou3_cancelled if it was cancelled). Can be called only once.
+      const Table& get() { return *future_.get(); }
+
+      bool valid() const { return future_.valid(); }
+      // whether generation finished
+      bool ready() const { return future_.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }
+      void wait() const { future_.wait(); }
+
+      // Requests cancellation of generation, which stops at the next row of Gelfand patterns; may be called by any thread.
+      void cancel() { if (cancelled_) cancelled_->store(true); }
+
+   private:
+      std::future<const Table*> future_;
+      std::shared_ptr<std::atomic<bool>> cancelled_;
+};
+#endif /* UNTOU3_ENABLE_THREADS */
+
+#ifdef UNTOU3_ENABLE_MPI
+// Auxiliary functions for summation of arrays of multiplicities of U(3) weights over ranks of an MPI communicator.
+// Predefined MPI datatypes are used for fixed-width unsigned types, multiplicities of other types (e.g., untou3_uint128)
+// are summed by a user-defined operation.
+template <typename U> inline MPI_Datatype untou3_mpi_datatype() { return MPI_DATATYPE_NULL; }
+template <> inline MPI_Datatype untou3_mpi_datatype<uint16_t>() { return MPI_UINT16_T; }
+template <> inline MPI_Datatype untou3_mpi_datatype<uint32_t>() { return MPI_UINT32_T; }
+template <> inline MPI_Datatype untou3_mpi_datatype<uint64_t>() { return MPI_UINT64_T; }
+
+template <typename U>
+void untou3_mpi_sum(void* in, void* inout, int* length, MPI_Datatype*)
+{
+   const U* src = static_cast<const U*>(in);
+   U* dst = static_cast<U*>(inout);
+   for (int i = 0; i < *length; i++) dst[i] += src[i];
+}
+
+// sums arrays data of a given length of all ranks of comm in place
+template <typename U>
+void untou3_mpi_allreduce_sum(U* data, size_t length, MPI_Comm comm)
+{
+   MPI_Datatype type = untou3_mpi_datatype<U>();
+   MPI_Op op = MPI_SUM;
+   const bool predefined = (type != MPI_DATATYPE_NULL);
+   if (!predefined) {
+      MPI_Type_contiguous(sizeof(U), MPI_BYTE, &type);
+      MPI_Type_commit(&type);
+      MPI_Op_create(&untou3_mpi_sum<U>, 1, &op);
+   }
+
+   // counts of MPI functions are of type int
+   const size_t max_count = std::numeric_limits<int>::max();
+   for (size_t offset = 0; offset < length; offset += max_count) 
+      MPI_Allreduce(MPI_IN_PLACE, data + offset, (int)std::min(max_count, length - offset), type, op, comm);
+
+   if (!predefined) {
+      MPI_Op_free(&op);
+      MPI_Type_free(&type);
    }
+}
+#endif /* UNTOU3_ENABLE_MPI */
+
+#ifdef UNTOU3_ENABLE_STATS
+// Statistics of the last call of UNtoU3::generateU3Weights, which are collected by the RECURSIVE engine on the host
+// (other engines and the offload backend only set the table size and capacity).
+struct untou3_stats
+{
+   // visited Gelfand pattern rows above leaves of the recursion, and generated Gelfand patterns (sum of multiplicities)
+   uint64_t rows = 0, patterns = 0;
+   // additions of precalculated leaf tables by levels of leaf rows (empty if UNTOU3_DISABLE_PRECALC is defined)
+   std::vector<uint64_t> leaf_hits;
+   // lower rows generated by new tasks (or pushed into work-stealing queues), and by recursive calls or iterations
+   uint64_t tasks_spawned = 0, tasks_inlined = 0;
+   // changes of numbers of buckets (or slots) of tables observed by additions of weights
+   uint64_t rehashes = 0;
+   // number of weights and buckets (or slots, zero if not applicable) of the resulting table
+   size_t table_size = 0, table_capacity = 0;
+   // time in seconds spent by each thread (or executor worker) by generation of subtrees and by merging of tables
+   std::vector<double> busy_time, merge_time;
+};
+
+// An auxiliary struct with statistics of a single thread, which are summed into untou3_stats after generation.
+struct untou3_thread_stats
+{
+   uint64_t rows = 0, patterns = 0, tasks_spawned = 0, tasks_inlined = 0, rehashes = 0;
+   std::vector<uint64_t> leaf_hits;
+   // last observed capacity of the table of the thread
+   size_t capacity = 0;
+   // nesting of recursive calls, only the outermost ones are timed
+   size_t depth = 0;
+   std::chrono::steady_clock::time_point start;
+   double busy_time = 0.0, merge_time = 0.0;
+};
+
+// Measures busy time of a thread by the outermost recursive call (a task executed by the thread) in its scope.
+class untou3_busy_scope
+{
+   public:
+      explicit untou3_busy_scope(untou3_thread_stats* stats) : stats_(stats) 
+      {
+         if (stats_ && (stats_->depth++ == 0))
+            stats_->start = std::chrono::steady_clock::now();
+      }
+      ~untou3_busy_scope() 
+      {
+         if (stats_ && (--stats_->depth == 0))
+            stats_->busy_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - stats_->start).count();
+      }
+      untou3_busy_scope(const untou3_busy_scope&) = delete;
+      untou3_busy_scope& operator=(const untou3_busy_scope&) = delete;
+   private:
+      untou3_thread_stats* stats_;
 };
-#endif /* UNTOU3_DISABLE_UNORDERED */
+#endif /* UNTOU3_ENABLE_STATS */
+
+// generators specialized for fixed HO levels and for higher labels of U(N) irreps (see below)
+template <int n, typename T, typename U>
+class UNtoU3Fixed;
+template <int L, typename T, typename U>
+class UNtoU3Labels;
 
 // Generates U(3) weights and their multiplicites in an input U(N) irrep and allows to evaluate their level dimensionalities.
-// Lables of U(N) are limited to {2,1,0}.
+// Lables of U(N) are limited to {2,1,0} (see UNtoU3Labels for higher labels).
 //
 // T - type of the computer representation of U(3) weight labels
 // U - type used for storing multiplicities of U(3) weights
@@ -55,256 +862,2927 @@ struct array_3_hasher
 //    }
 template <typename T = uint32_t, typename U = uint32_t>
 class UNtoU3 {
+   template <int, typename, typename> friend class UNtoU3Fixed;
+   template <int, typename, typename> friend class UNtoU3Labels;
+
    public:
-      UNtoU3();
-      ~UNtoU3();
+      // type for storing labels of U(3) weights
+      using U3Weight = std::array<T, 3>;
+
+      // type of the data structure used for storing U(3) weights and their multiplicities
+#if defined(UNTOU3_ENABLE_DENSE)
+      using U3MultMap = array_3_dense_map<T, U>;
+#elif defined(UNTOU3_ENABLE_FLAT)
+      using U3MultMap = array_3_flat_map<T, U>;
+#elif !defined(UNTOU3_DISABLE_UNORDERED)
+      using U3MultMap = std::unordered_map<U3Weight, U, array_3_hasher<T>>;
+#else 
+      using U3MultMap = std::map<U3Weight, U>;
+#endif /* U3MultMap */
+
+      // type of a sparse table of U(3) weights and their multiplicities sorted lexicographically by weight labels
+      using U3WeightTable = std::vector<std::pair<U3Weight, U>>;
+
+      // type of the representation of a single Gelfand pattern row, which contain its number of twos, ones, and zeros
+      using GelfandRow = std::array<uint16_t, 3>;
+      // type of a Galfand pattern labels
+      using GRT = GelfandRow::value_type;
+
+      // definition of the order of axis for weight vectors
+      enum { NZ, NX, NY };
+
+      // policies for spawning of OpenMP tasks (or splitting of subtrees by executor workers) by the RECURSIVE engine
+      enum class TaskCutoff {
+         DEPTH,            // lower rows of rows within a given depth from the input row are generated by new tasks
+         SUBTREE_SIZE,     // lower rows of rows with more than a given number of Gelfand patterns are generated by new tasks
+         TASKS_PER_THREAD, // as SUBTREE_SIZE, with a threshold that yields approximately a given number of tasks per thread
+         AUTO              // as SUBTREE_SIZE, with a threshold that yields tasks of a given duration in seconds,
+                           // which is estimated from a sampling pass over a smaller subtree
+      };
+
+      // algorithms for generation of U(3) weights
+      enum class Engine {
+         RECURSIVE, // enumeration of individual Gelfand patterns (reference algorithm)
+         MEMOIZED,  // dynamic programming over Gelfand pattern rows, tables of subtrees are evaluated only once
+         GENERATING_FUNCTION // multiplication of polynomials in weights of HO states, independent of dim[f]
+      };
+
+      // Generates HO quanta vectors for given nth HO level.
+      // Need to be used befor generateU3Weights member function is called.
+      // Quanta vectors and precalculated contributions of leaf rows of a HO level are calculated only by the first call
+      // in the process and shared by all instances afterwards (calls from multiple threads are safe).
+      void generateXYZ(int n);
+
+      // Sets the number of lowest Gelfand pattern rows whose contributions to U(3) weights are precalculated
+      // (UNTOU3_PRECALC_DEPTH by default, at least 1). Deeper tables shorten the recursion, but the number of their entries 
+      // grows quickly; depths of 3 to 6 are reasonable. Has no effect if UNTOU3_DISABLE_PRECALC is defined.
+      void setPrecalcDepth(size_t depth);
+
+      // Generates U(3) weights and their multiplicities for an input U(N) irrep [f].
+      // [f] is specified by the number of twos n2, ones n1, and zeros n0.
+      // N=n2+n1+n0 must be equal to (n+1)*(n+2)/2, where n was used as an argument of generateXYZ.
+      // All engines produce the same table, RECURSIVE is kept as a reference.
+      void generateU3Weights(uint16_t n2, uint16_t n1, uint16_t n0, Engine engine = Engine::RECURSIVE);
+
+#ifdef UNTOU3_ENABLE_THREADS
+      // Starts generateU3Weights(n2, n1, n0, engine) by a new std::thread and returns a handle of the resulting table.
+      // Generation runs by workers of the executor set by setExecutor, otherwise by at most threads OpenMP threads 
+      // (serially without OpenMP), the calling thread and its OpenMP team are thus free to do other work meanwhile.
+      // The instance must not be used until generation finishes; tables of multiple irreps generated concurrently
+      // need multiple instances. Cancellation stops the RECURSIVE and MEMOIZED engines early and leaves the table empty.
+      // Asynchronous generation is not distributed by MPI.
+      untou3_future<U3MultMap> generateU3WeightsAsync(uint16_t n2, uint16_t n1, uint16_t n0, int threads = 1,
+            Engine engine = Engine::RECURSIVE);
+#endif
+
+      // Generates U(3) weights of an input U(N) irrep [f] specified by n2, n1, and n0 as above, but instead of storing them
+      // into a table, passes them to sink(weight, count) at leaves of the recursion (or for each entry of a precalculated
+      // leaf table), where count is the number of Gelfand patterns of a subtree that generate the weight. The same weight
+      // is thus passed many times and its multiplicity is the sum of its counts. The sink is called sequentially by
+      // the calling thread, its call can be inlined into the recursion. multMap() is not affected.
+      // Reductions over U(3) irreps can be evaluated by untou3_irrep_sink, multiple sinks can be combined by untou3_compose.
+      template <typename Sink>
+      void generateU3Weights(uint16_t n2, uint16_t n1, uint16_t n0, Sink&& sink) const 
+      {
+         visitRec(GelfandRow{ n2, n1, n0 }, U3Weight{ 0, 0, 0 }, sink);
+      }
+
+      // Provides an access to the table of U(3) weights and their multiplicities generated by generateU3Weights.
+      // Returns a constant reference to the computer representation of this table of type U3MultMap.
+      const U3MultMap& multMap() const { return mult_; }
+
+      // Generates U(3) weights and their multiplicities for a list of input U(N) irreps of the HO level set by generateXYZ,
+      // each specified by its number of twos, ones, and zeros {n2, n1, n0}. Returns one table per irrep in the same order.
+      // Tables of subtrees of Gelfand patterns are evaluated as by the MEMOIZED engine, but only once for all irreps,
+      // since all of them reach the same lower rows. multMap() is not affected.
+      // Tables of irreps that are repeated, or complements of other irreps of the list, are derived by complementWeights.
+      std::vector<U3MultMap> generateU3WeightsBatch(const std::vector<GelfandRow>& irreps);
+
+      // Fills a table dst by U(3) weights and their multiplicities of the complement [2^n0 1^n1 0^n2] of an input U(N) irrep [f]
+      // specified by n2, n1, and n0, given a table src of [f] (of any type with the same iteration interface as U3MultMap, 
+      // such as array_3_mapped_table). HO states occupied m times in Gelfand patterns of [f] are occupied 2 - m times 
+      // in those of the complement, its U(3) weights are thus 2 * Q - w for weights w of [f], where Q is the sum of quanta 
+      // of all HO states along an axis (the same for all of them), and multiplicities are equal. Labels of these weights 
+      // are reversed, which keeps the table symmetric and weights close to the dominant chamber close to it.
+      // U(3) irreps [f1,f2,f3] of [f] thus become [2Q-f3,2Q-f2,2Q-f1] of the complement with the same level dimensionalities.
+      template <typename Table>
+      void complementWeights(const Table& src, U3MultMap& dst, uint16_t n2, uint16_t n1, uint16_t n0) const;
+      // Replaces the table generated by generateU3Weights for [f] specified by n2, n1, and n0 by the table 
+      // of its complement [2^n0 1^n1 0^n2] (see complementWeights), which is cheaper than its generation.
+      void complement(uint16_t n2, uint16_t n1, uint16_t n0);
+
+      // Get level dimensionality for a given U(3) weight passed as an argument.
+      // It is evaluated in the modular arithmetic of U, intermediate wraparounds thus do not affect the result.
+      // After finalize, it is looked up in the index of U(3) irreps without hashing (zero for weights not in the table).
+      U getLevelDimensionality(const U3Weight& labels) const 
+      { 
+         return irrep_ptr_.empty() ? getLevelDimensionality(mult_, labels) : findLevelDimensionality(labels); 
+      }
+      // Get level dimensionality for a given U(3) weight in a given table (e.g., returned by generateU3WeightsBatch,
+      // or any table with the same find/end interface, such as array_3_mapped_table).
+      template <typename Table>
+      static U getLevelDimensionality(const Table& table, const U3Weight& labels);
+
+      // Returns U(3) irreps [f1,f2,f3] (f1 >= f2 >= f3) with nonzero level dimensionalities contained in the table
+      // generated by generateU3Weights, sorted lexicographically, together with their level dimensionalities.
+      // The corresponding SU(3) irreps are (lambda, mu) = (f1 - f2, f2 - f3).
+      U3WeightTable getIrreps() const { return getIrreps(mult_); }
+
+      // Evaluates level dimensionalities of all U(3) irreps of the table generated by generateU3Weights once into 
+      // a compact index, which is then used by getLevelDimensionality until the next generation. The index stores 
+      // only irreps with nonzero level dimensionalities: they have the same sum of labels, so they are identified 
+      // by (lambda, mu) and sorted by lambda into rows, which are searched for mu by a binary search.
+      void finalize();
+      // whether the index of U(3) irreps is built for the current table
+      bool finalized() const { return !irrep_ptr_.empty(); }
+
+      // Sum of dimensions of U(3) irreps of the table multiplied by their level dimensionalities, which is evaluated 
+      // by finalize in exact integer arithmetic (zero if the table is not finalized). 
+      const untou3_bigint& irrepsDimension() const { return irrep_total_; }
+      // Dimension dim[f] of an input U(N) irrep [f] specified by the number of twos n2, ones n1, and zeros n0
+      // evaluated exactly by the hook content formula.
+      static untou3_bigint dimension(uint16_t n2, uint16_t n1, uint16_t n0);
+      // Throws std::runtime_error unless irrepsDimension of the finalized table equals dim[f] of [f] specified by n2, n1, 
+      // and n0, which is the irrep the table was generated for. Since the check is exact, it detects level dimensionalities
+      // that do not fit into U (overflows of multiplicities alone are harmless), as well as incorrect tables.
+      void validate(uint16_t n2, uint16_t n1, uint16_t n0) const;
+      // Returns U(3) irreps and their level dimensionalities contained in a given table.
+      // For the dense backend, level dimensionalities are evaluated by a single sweep over the underlying array.
+      static U3WeightTable getIrreps(const U3MultMap& table);
+
+      // Sets the policy for spawning of OpenMP tasks and its parameter (see TaskCutoff). 
+      // The default policy is TASKS_PER_THREAD with 64 tasks per thread. Has no effect if generation is serial.
+      // The same policy determines subtrees that are split into work-stealing queues of executor workers.
+      void setTaskCutoff(TaskCutoff policy, double value) { task_cutoff_ = policy; task_cutoff_value_ = value; }
+
+      // Sets the number of levels of Gelfand pattern rows below the input row that are enumerated before parallel generation.
+      // If nonzero, subtrees of rows at this depth are partitioned statically into contiguous chunks with similar numbers 
+      // of Gelfand patterns, one per thread (or executor worker), which generates them without tasks or synchronization.
+      // Timing and the resulting table, including its iteration order, are then repeatable for a given number of threads.
+      // Zero (default) selects dynamic scheduling by OpenMP tasks or work stealing.
+      void setStaticPartitioning(size_t depth) { static_depth_ = depth; }
+
+#ifdef UNTOU3_ENABLE_THREADS
+      // Sets an executor that runs parallel generation of U(3) weights by the RECURSIVE engine instead of OpenMP.
+      // Workers split the tree of Gelfand patterns dynamically, each of them owns a work-stealing queue of subtrees.
+      // The executor is not owned by the instance and needs to exist during generation; nullptr unsets it.
+      void setExecutor(untou3_executor* executor) { executor_ = executor; }
+#endif
+
+#ifdef UNTOU3_ENABLE_OFFLOAD
+      // Sets the OpenMP device that generates U(3) weights by the RECURSIVE engine (omp_get_default_device() by default 
+      // if a device is available), a negative device disables offloading. Top rows of the tree of Gelfand patterns are 
+      // expanded by the host into at least a given number of subtrees, which are then generated by the device in parallel;
+      // trees of fewer Gelfand patterns are generated by the host (by OpenMP threads if enabled). Multiplicities 
+      // of weights are accumulated by atomic updates of a dense array, U thus needs to be supported by device atomics.
+      // Takes precedence over OpenMP threads (not over an executor), setTaskCutoff and setStaticPartitioning have no effect
+      // on offloaded generation. (The initial device omp_get_initial_device() runs the device code on the host.)
+      void setOffload(int device, size_t subtrees = 1 << 16) { offload_device_ = device; offload_subtrees_ = subtrees; }
+#endif
+
+#ifdef UNTOU3_ENABLE_MPI
+      // Sets an MPI communicator whose ranks share generation of U(3) weights by the RECURSIVE engine; MPI_COMM_NULL 
+      // (default) unsets it. The tree of Gelfand patterns is split into subtrees, each rank generates a contiguous share 
+      // of them with a similar number of Gelfand patterns (in parallel by OpenMP threads or an executor as without MPI), 
+      // and tables of all ranks are summed by MPI_Allreduce. All ranks thus need to call generateU3Weights with the same
+      // arguments, all of them then obtain the whole table. MPI functions are called only by the calling thread.
+      // The MEMOIZED engine and generateU3WeightsBatch are not distributed.
+      void setCommunicator(MPI_Comm comm) { comm_ = comm; }
+#endif
+
+      // Time in seconds spent by merging of thread-local tables in the last call of generateU3Weights
+      // (zero if generation was serial or the MEMOIZED engine was used).
+      double mergeTime() const { return merge_time_; }
+
+#ifdef UNTOU3_ENABLE_STATS
+      // Statistics of the last call of generateU3Weights (see untou3_stats).
+      const untou3_stats& stats() const { return stats_; }
+#endif
+
+      // Calculates the lowest and highest values of individual labels of U(3) weights in an input U(N) irrep [f]
+      // specified by the number of twos n2, ones n1, and zeros n0. All weights have the same sum of labels n*(2*n2+n1).
+      void getWeightBounds(uint16_t n2, uint16_t n1, uint16_t n0, U3Weight& lo, U3Weight& hi) const;
+
+      // Upper bounds of labels of U(3) weights and of their multiplicities in an input U(N) irrep [f] of the HO level n 
+      // specified by the number of twos n2, ones n1, and zeros n0. Labels do not exceed their sum n*(2*n2+n1). 
+      // Multiplicities, as well as all partial sums during generation, do not exceed the number of Gelfand patterns dim[f],
+      // which is evaluated by the hook content formula in floating-point arithmetic and rounded up.
+      static uint64_t maxLabel(int n, uint16_t n2, uint16_t n1, uint16_t) { return (uint64_t)n * (2 * n2 + n1); }
+      static long double maxMultiplicity(uint16_t n2, uint16_t n1, uint16_t n0);
+
+      // Estimates the number of U(3) weights in an input U(N) irrep [f] specified by n2, n1, and n0 from bounds of their
+      // labels (see getWeightBounds). Since the third label is implied by the first two, the estimate is an upper bound.
+      size_t estimateSize(uint16_t n2, uint16_t n1, uint16_t n0) const;
+
+      // Reserves capacity of the resulting and thread-local tables for U(3) weights of [f] specified by n2, n1, and n0
+      // (according to estimateSize). generateU3Weights reserves capacity for its input irrep as well, but a reservation 
+      // for the largest irrep of a sweep can avoid repeated rehashing. Has no effect for the dense backend and binary search trees.
+      void reserve(uint16_t n2, uint16_t n1, uint16_t n0);
+
+   private:
+      // HO quanta vectors of a HO level and data derived from them that do not depend on input irreps. They are 
+      // immutable and shared by all instances of the process with the same types, HO level, and depth of precalculated 
+      // rows (see getShell).
+      struct Shell {
+         std::array<std::vector<uint32_t>, 3> xyz;
+         // quanta along individual axes sorted in ascending order (see getWeightBounds)
+         std::array<std::vector<uint32_t>, 3> sorted;
+#ifndef UNTOU3_DISABLE_PRECALC
+         // rows of lower levels than leaf_level are leaves of the recursion
+         size_t leaf_level = 0;
+         // Precalculated contributions of leaf rows: distinct U(3) weights generated by their subtrees and numbers 
+         // of Gelfand patterns that generate them. The entries of a row gpr are stored at positions 
+         // [leaf_ptr[leafIndex(gpr)], leaf_ptr[leafIndex(gpr) + 1]), weights as triples of labels.
+         std::vector<uint32_t> leaf_ptr;
+         std::vector<T> leaf_weights;
+         std::vector<U> leaf_counts;
+#endif
+#ifdef UNTOU3_ENABLE_DOMINANT
+         // sums of the k highest differences of quanta xyz[0] - xyz[1] (and xyz[1] - xyz[2]) of HO states 0 to N,
+         // which are stored at positions dominant_ptr[N] + k; weights of the subtree of a row {n2, n1, n0} of level N 
+         // have the highest difference of labels equal to the sum of sums of n2 and n2 + n1 highest differences of quanta
+         std::array<std::vector<int64_t>, 2> dominant_sums;
+         std::vector<size_t> dominant_ptr;
+#endif
+      };
+
+      // Returns data of the HO level n with a given depth of precalculated rows (zero if UNTOU3_DISABLE_PRECALC
+      // is defined). They are calculated by the first call and kept until the end of the process. Thread-safe.
+      static const Shell* getShell(int n, size_t depth);
+
+      // HO level generated by generateXYZ and its data
+      int n_ = 0;
+      const Shell* shell_ = nullptr;
+      // table of resulting U(3) irreps and their multiplicities
+      U3MultMap mult_;
+      // time of the last merge of thread-local tables
+      double merge_time_ = 0.0;
+
+      // index of U(3) irreps built by finalize, irreps with lambda = f1 - f2 are at positions irrep_ptr_[lambda] 
+      // to irrep_ptr_[lambda + 1] - 1 of irrep_mu_ (sorted mu = f2 - f3) and irrep_dim_ (level dimensionalities),
+      // all of them have the sum of labels irrep_sum_; it is empty if not built
+      std::vector<uint32_t> irrep_ptr_;
+      std::vector<T> irrep_mu_;
+      std::vector<U> irrep_dim_;
+      T irrep_sum_ = 0;
+      // see irrepsDimension
+      untou3_bigint irrep_total_;
+
+      // level dimensionality of a weight found in the index of U(3) irreps
+      U findLevelDimensionality(const U3Weight& labels) const;
+      // releases the index of U(3) irreps, which needs to be called by generators of new tables
+      void clearIndex() { irrep_ptr_.clear(); irrep_mu_.clear(); irrep_dim_.clear(); irrep_total_ = 0; }
+
+#ifdef UNTOU3_ENABLE_STATS
+      untou3_stats stats_;
+      // statistics of threads of the last generation (the first stats_threads_ ones are used), each thread binds 
+      // its own one to thread_stats_ before it generates subtrees
+      std::vector<std::unique_ptr<untou3_thread_stats>> stats_tl_;
+      size_t stats_threads_ = 0;
+      static thread_local untou3_thread_stats* thread_stats_;
+
+      // prepares statistics of a given number of threads
+      void resetStats(size_t threads);
+      // returns statistics of thread t, which generates subtrees into mult, to be bound to the calling thread
+      untou3_thread_stats* bindStats(size_t t, const U3MultMap& mult) 
+      {
+         untou3_thread_stats* stats = stats_tl_[t].get();
+         stats->capacity = tableCapacity(mult, 0);
+         return stats;
+      }
+      // Binds statistics to the calling thread (nullptr disables counting) and restores the previous binding 
+      // at the end of its scope, so that no thread points to statistics of a generator after its generation.
+      class StatsScope 
+      {
+         public:
+            explicit StatsScope(untou3_thread_stats* stats) : previous_(thread_stats_) { thread_stats_ = stats; }
+            ~StatsScope() { thread_stats_ = previous_; }
+            StatsScope(const StatsScope&) = delete;
+            StatsScope& operator=(const StatsScope&) = delete;
+         private:
+            untou3_thread_stats* previous_;
+      };
+      // sums statistics of threads into stats_
+      void collectStats();
+      // counts a row gpr visited by the recursion and its lower rows, which are generated by new tasks if spawn is true 
+      // (pushed into a work-stealing queue if also queued is true)
+      static void countRow(const GelfandRow& gpr, bool spawn, bool queued);
+      // counts an addition of a leaf row at level N with count Gelfand patterns into mult
+      static void countLeaf(size_t N, uint64_t count, const U3MultMap& mult);
+
+      // number of buckets (or slots) of a table if its type provides it
+      template <typename M>
+      static auto tableCapacity(const M& mult, int) -> decltype(mult.bucket_count()) { return mult.bucket_count(); }
+      template <typename M>
+      static auto tableCapacity(const M& mult, long) -> decltype(mult.capacity()) { return mult.capacity(); }
+      template <typename M>
+      static size_t tableCapacity(const M&, ...) { return 0; }
+#endif
+
+#ifdef UNTOU3_ENABLE_THREADS
+      // cancellation flag of the running asynchronous generation, if any
+      std::atomic<bool>* cancel_ = nullptr;
+      bool cancelled() const { return cancel_ && cancel_->load(std::memory_order_relaxed); }
+#else
+      static constexpr bool cancelled() { return false; }
+#endif
+
+      // policy for spawning of OpenMP tasks and its parameter
+      TaskCutoff task_cutoff_ = TaskCutoff::TASKS_PER_THREAD;
+      double task_cutoff_value_ = 64;
+      // lower rows of a row at level N are generated by new tasks if N >= task_level_
+      // and the row has more than task_patterns_ Gelfand patterns (negative if not limited)
+      size_t task_level_ = 0;
+      double task_patterns_ = -1.0;
+
+      // subtrees (rows and partial contributions of higher rows) generated into mult_ by the RECURSIVE engine,
+      // which is the input row, or the share of the tree of the calling MPI rank
+      std::vector<std::pair<GelfandRow, U3Weight>> roots_;
+
+      // depth of the static partitioning, subtrees of rows at this depth, and the first subtree of each chunk
+      size_t static_depth_ = 0;
+      std::vector<std::pair<GelfandRow, U3Weight>> frontier_;
+      std::vector<size_t> chunks_;
+
+      // numbers of Gelfand patterns of subtrees of rows calculated by countPatterns,
+      // indexed by the number of twos and zeros and the level of a row
+      std::vector<double> patterns_;
+      size_t patterns_n0_ = 0, patterns_N_ = 0;
+
+      // Calculates numbers of Gelfand patterns of subtrees of all rows that can occur in Gelfand patterns 
+      // of an input U(N) irrep [f] specified by n2, n1, and n0.
+      void countPatterns(uint16_t n2, uint16_t n1, uint16_t n0);
+      // number of Gelfand patterns of a subtree of a given row (countPatterns needs to be called before)
+      double patterns(const GelfandRow& gpr) const
+      {
+         return patterns_[(gpr[0] * (patterns_n0_ + 1) + gpr[2]) * patterns_N_ + (gpr[0] + gpr[1] + gpr[2] - 1)];
+      }
+
+      // Replaces subtrees by subtrees of their lower rows level by level, which keeps them in the order of the recursion, 
+      // until depth levels are expanded or there are at least size subtrees.
+      void expandSubtrees(std::vector<std::pair<GelfandRow, U3Weight>>& subtrees, size_t depth, size_t size) const;
+      // Partitions subtrees into a given number of contiguous chunks with similar numbers of Gelfand patterns,
+      // the chunk c consists of subtrees [bounds[c], bounds[c + 1]) (countPatterns needs to be called before).
+      void partitionSubtrees(const std::vector<std::pair<GelfandRow, U3Weight>>& subtrees, size_t chunks, 
+            std::vector<size_t>& bounds) const;
+
+      // generates subtrees of roots_ into mult_ by OpenMP threads, executor workers, or serially
+      void generateRoots(uint16_t n2, uint16_t n1, uint16_t n0);
+
+      // recursion of generateU3Weights with a sink
+      template <typename Sink>
+      void visitRec(const GelfandRow& gpr, const U3Weight& pp, Sink& sink) const;
+
+      // weight w shifted by d quanta of the level N
+      U3Weight shifted(const U3Weight& w, T d, size_t N) const
+      {
+         return { (T)(w[0] + d * shell_->xyz[0][N]), (T)(w[1] + d * shell_->xyz[1][N]), (T)(w[2] + d * shell_->xyz[2][N]) };
+      }
+      static U3Weight add(const U3Weight& w, const U3Weight& v)
+      {
+         return { (T)(w[0] + v[0]), (T)(w[1] + v[1]), (T)(w[2] + v[2]) };
+      }
+
+      // whether a weight is recorded into tables (see UNTOU3_ENABLE_DOMINANT)
+#ifdef UNTOU3_ENABLE_DOMINANT
+      static bool recorded(const U3Weight& w) { return (w[0] + 1 >= w[1]) && (w[1] + 1 >= w[2]); }
+#else
+      static constexpr bool recorded(const U3Weight&) { return true; }
+#endif
+
+#ifdef UNTOU3_ENABLE_DOMINANT
+      // calculates dominant sums of a shell
+      static void init_dominant(Shell& shell);
+      // whether the subtree of a row gpr of level N shifted by pp may contain weights recorded into tables
+      bool reachesDominant(const GelfandRow& gpr, const U3Weight& pp, size_t N) const
+      {
+         for (int k = 0; k < 2; k++) {
+            const int64_t* sums = shell_->dominant_sums[k].data() + shell_->dominant_ptr[N];
+            if ((int64_t)pp[k] + sums[gpr[0]] + sums[gpr[0] + gpr[1]] + 1 < (int64_t)pp[k + 1]) return false;
+         }
+         return true;
+      }
+#endif
+
+#ifdef UNTOU3_ENABLE_OVERFLOW_CHECK
+      // throws std::overflow_error if labels or multiplicities in [f] specified by n2, n1, and n0 might overflow T or U
+      void checkBounds(uint16_t n2, uint16_t n1, uint16_t n0) const;
+#endif
+
+      // prepares a table for generation of U(3) weights of [f] specified by n2, n1, and n0
+      void resetMult(U3MultMap& mult, uint16_t n2, uint16_t n1, uint16_t n0) const;
+      // Adds multiplicities of mult_ into a dense array indexed by first two labels of weights within bounds of [f] 
+      // specified by n2, n1, and n0 (see getWeightBounds), or replaces mult_ by weights of such an array.
+      void addToDense(std::vector<U>& data, uint16_t n2, uint16_t n1, uint16_t n0) const;
+      void resetFromDense(const std::vector<U>& data, uint16_t n2, uint16_t n1, uint16_t n0);
+      // reserves capacity of a table for a given number of weights if its type supports that
+      // (std::unordered_map::reserve may also shrink the bucket array, which is then allocated again by each generation)
+      template <typename M>
+      static auto reserveTable(M& mult, size_t size, int) -> decltype(mult.bucket_count(), void()) 
+      { 
+         if (size > mult.bucket_count() * mult.max_load_factor()) mult.reserve(size); 
+      }
+      template <typename M>
+      static auto reserveTable(M& mult, size_t size, long) -> decltype(mult.reserve(size), void()) { mult.reserve(size); }
+      template <typename M>
+      static void reserveTable(M&, size_t, ...) { }
+
+#ifndef UNTOU3_DISABLE_PRECALC
+      // number of precalculated lowest rows (see Shell::leaf_level)
+      size_t precalc_depth_ = UNTOU3_PRECALC_DEPTH;
+#ifdef UNTOU3_ENABLE_DENSE
+      // positions of leaf weights in dense tables relative to the position of the partial contribution pp
+      std::vector<std::ptrdiff_t> leaf_offsets_;
+#endif
+
+      size_t leafIndex(const GelfandRow& gpr) const { return leafIndex(*shell_, gpr); }
+      static size_t leafIndex(const Shell& shell, const GelfandRow& gpr) 
+      { 
+         return (gpr[0] * (shell.leaf_level + 1) + gpr[1]) * (shell.leaf_level + 1) + gpr[2]; 
+      }
+
+      // adds precalculated contributions of a leaf row gpr shifted by pp to mult
+      void addLeaves(const GelfandRow& gpr, const U3Weight& pp, U3MultMap& mult) const;
+#endif
+
+#if !defined(UNTOU3_DISABLE_PRECALC) && defined(UNTOU3_ENABLE_DENSE)
+      // calculates leaf_offsets_ for the shape of mult_ (all tables of an irrep have the same shape)
+      void init_leaf_offsets();
+#endif
+
+#if defined(UNTOU3_ENABLE_OPENMP) || defined(UNTOU3_ENABLE_THREADS)
+      // thread-local tables (of OpenMP threads or executor workers) for generated U(3) weights and their multiplicites, 
+      // which are finally merged into mult_; they are owned by the instance, allocated lazily by the threads 
+      // that use them, and reused by subsequent calls
+      std::vector<std::unique_ptr<U3MultMap>> mult_tl_;
+
+      // Sets task_level_ and task_patterns_ according to the task spawning policy for [f] specified by n2, n1, and n0,
+      // which is generated by a given number of threads.
+      void setupTasks(uint16_t n2, uint16_t n1, uint16_t n0, size_t threads);
+
+      // Enumerates subtrees of rows static_depth_ levels below roots_ of [f] specified by n2, n1, and n0 into frontier_ 
+      // and partitions them into a given number of chunks.
+      void partitionStatic(uint16_t n2, uint16_t n1, uint16_t n0, size_t chunks);
+      // generates subtrees of the chunk c into mult
+      void generateChunk(size_t c, U3MultMap& mult);
+#endif
+
+#ifdef UNTOU3_ENABLE_OPENMP
+      // Merges thread-local tables of all threads of the current team into the table of thread 0.
+      // Needs to be called by all threads of the team. Dense tables are partitioned by ranges of positions, 
+      // all threads merge their own partitions. Other tables are merged by a pairwise tree reduction.
+      // With UNTOU3_ENABLE_NUMA, tables are first merged within NUMA nodes (see orderNuma).
+      void mergeThreadLocal();
+#endif 
+
+#ifdef UNTOU3_ENABLE_NUMA
+      // NUMA nodes on which thread-local tables were first touched (by their threads)
+      std::vector<int> numa_tl_;
+      // threads of the current team ordered by NUMA nodes (the node of thread 0 first), 
+      // and offsets of the threads of each node in numa_order_ (with the team size appended)
+      std::vector<size_t> numa_order_, numa_begin_;
+
+      // returns the NUMA node of the core that runs the calling thread (0 if it cannot be determined)
+      static int numaNode();
+      // Releases the thread-local table of the calling OpenMP thread if it was first touched on another NUMA node,
+      // so that it is allocated and first touched again by resetMult. Needs to be called by all threads of the team
+      // after mult_tl_ and numa_tl_ are resized for the team.
+      void placeNuma();
+      // sets numa_order_ and numa_begin_ for numa_tl_ of nt threads
+      void orderNuma(size_t nt);
+#endif
+
+      // work-stealing queue of subtrees (rows and partial contributions of higher rows) of an executor worker;
+      // its owner pushes and pops subtrees at the back, other workers steal them at the front
+      struct WorkQueue;
+
+#ifdef UNTOU3_ENABLE_THREADS
+      struct WorkQueue {
+         std::mutex mutex;
+         std::deque<std::pair<GelfandRow, U3Weight>> subtrees;
+         // number of subtrees pushed into queues of all workers that have not been generated yet
+         std::atomic<size_t>* pending;
+         // set if generation of a subtree threw, all workers then stop
+         std::atomic<bool>* abort;
+      };
+
+      // executor for parallel generation, if set
+      untou3_executor* executor_ = nullptr;
+
+      // Generates U(3) weights of [f] specified by n2, n1, and n0 by workers of executor_.
+      void generateU3WeightsExec(uint16_t n2, uint16_t n1, uint16_t n0);
+      // Generates subtrees from queues[w] and subtrees stolen from other queues into the table of worker w
+      // until all subtrees are generated.
+      void runWorker(std::vector<WorkQueue>& queues, size_t w);
+      // Pushes subtrees of lower rows of a row gpr at level N into a work-stealing queue.
+      void pushLowerRows(const GelfandRow& gpr, const U3Weight& pp, size_t N, WorkQueue& queue) const;
+      // Merges tables of nw workers into the table of worker 0 by the executor.
+      void mergeWorkers(size_t nw);
+#endif
+
+#ifdef UNTOU3_ENABLE_OFFLOAD
+      // device (negative if none) and the minimum number of subtrees generated by the device
+      int offload_device_ = (omp_get_num_devices() > 0) ? omp_get_default_device() : -1;
+      size_t offload_subtrees_ = 1 << 16;
+      // maximum number of rows of subtrees generated by the device (the size of their stacks)
+      enum { offload_levels = 64 };
+
+      // returns true if [f] specified by n2, n1, and n0 is generated by the device (see setOffload)
+      bool offloaded(uint16_t n2, uint16_t n1, uint16_t n0);
+      // generates subtrees of roots_ into mult_ by the device
+      void generateOffload(uint16_t n2, uint16_t n1, uint16_t n0);
+#endif
+
+#ifdef UNTOU3_ENABLE_MPI
+      // communicator of ranks that share generation, if set
+      MPI_Comm comm_ = MPI_COMM_NULL;
+
+      // replaces roots_ by the share of the calling rank of subtrees of [f] specified by n2, n1, and n0
+      void distributeRoots(uint16_t n2, uint16_t n1, uint16_t n0);
+      // sums tables mult_ of all ranks, which are reduced as dense arrays indexed by first two labels of weights
+      void reduceRanks(uint16_t n2, uint16_t n1, uint16_t n0);
+#endif
+
+      // number of MPI ranks that share generation (1 without MPI)
+      size_t ranks() const
+      {
+#ifdef UNTOU3_ENABLE_MPI
+         int size = 1;
+         if (comm_ != MPI_COMM_NULL) MPI_Comm_size(comm_, &size);
+         return size;
+#else
+         return 1;
+#endif
+      }
+
+      // whether lower rows of a row gpr at level N are generated by new tasks (or pushed into a work-stealing queue)
+      bool spawnTasks(const GelfandRow& gpr, size_t N) const
+      {
+#if defined(UNTOU3_ENABLE_OPENMP) || defined(UNTOU3_ENABLE_THREADS)
+         return (N >= task_level_) && ((task_patterns_ < 0.0) || (patterns(gpr) > task_patterns_));
+#else
+         (void)gpr; (void)N;
+         return false;
+#endif
+      }
+
+      // Table to be used by a recursive call, which is a new task if spawn is true 
+      // (then, it is the thread-local table of the executing thread).
+      // The table of the caller is passed by a pointer, since a reference would be copied as firstprivate by a task.
+      U3MultMap& taskMult(bool spawn, U3MultMap* mult) 
+      {
+#ifdef UNTOU3_ENABLE_OPENMP
+         return spawn ? *mult_tl_[omp_get_thread_num()] : *mult;
+#else
+         (void)spawn;
+         return *mult;
+#endif
+      }
+
+      // Recursive function for generation of Gelfand patterns.
+      // It calls itself for all possible lower Gelfand pattern rows generated by the input Gelfand pattern row.
+      // At the end of recursion, it increments the multiplicity of resulting U(3) weight in mult.
+      // gpr - representation of an input gelfand pattern row 
+      // pp - partial contribution of higher Gelfand pattern rows to the generated U(3) weights
+      // mult - table of the calling thread, recursive calls (OpenMP tasks) use the table of their executing thread
+      // queue - work-stealing queue of the calling executor worker, where subtrees are split into, if any
+      void generateU3WeightsRec(GelfandRow gpr, U3Weight pp, U3MultMap& mult, WorkQueue* queue = nullptr);
+
+      // Generation of U(3) weights by dynamic programming over Gelfand pattern rows.
+      // U(3) weights generated by the subtree of a Gelfand pattern row depend only on its numbers of twos, ones, and zeros
+      // (higher rows only shift them). Tables of subtrees are therefore evaluated level by level from the bottom,
+      // each of them only once, and merged into tables of upper rows shifted by the contributions of their levels.
+      // Input rows gprs need to be of the same level, the table of gprs[i] is added into *mults[i].
+      void generateU3WeightsMemo(const std::vector<GelfandRow>& gprs, const std::vector<U3MultMap*>& mults);
+
+      // Dense polynomial in U(3) weights with a fixed sum of labels, whose coefficient of a weight w is
+      // c[(w[0] - lo[0]) * cols + (w[1] - lo[1])].
+      struct DensePoly
+      {
+         U3Weight lo;
+         size_t rows, cols;
+         std::vector<U> c;
+      };
+      // Adds a polynomial src multiplied by the monomial factor * x^d0 * y^d1 to dst. Terms out of bounds of dst 
+      // are skipped, since only zero coefficients of weights that cannot be reached are expected there.
+      static void addShifted(DensePoly& dst, const DensePoly& src, T d0, T d1, U factor);
+
+      // Generation of U(3) weights by the generating function of [f] specified by n2, n1, and n0. Multiplicities are
+      // coefficients of the Schur polynomial s_[f](x_1, ..., x_N), where x_i = x^xyz[0][i] y^xyz[1][i] z^xyz[2][i] 
+      // is the weight of ith HO state. Since [f] has two columns of heights n2 + n1 and n2, the dual Jacobi-Trudi identity 
+      // gives s_[f] = e_(n2+n1) e_n2 - e_(n2+n1+1) e_(n2-1), where elementary symmetric polynomials e_k are built up one 
+      // HO state at a time: e_k += x_i e_(k-1). All polynomials are dense 2D arrays indexed by first two labels (the third 
+      // one is implied by their sum), which are updated and multiplied row by row in contiguous inner loops. Coefficients are
+      // evaluated in the modular arithmetic of U, so that the result is exact whenever multiplicities of [f] fit into U
+      // (intermediate coefficients may exceed them); this is why floating-point FFT is not used for the multiplication.
+      void generateU3WeightsGF(uint16_t n2, uint16_t n1, uint16_t n0);
+
+      // Calls f(lgpr, d) for all lower Gelfand pattern rows lgpr generated by the input row gpr,
+      // where d is the difference of the sums of labels of gpr and lgpr.
+      template <typename F>
+      static void forEachLowerRow(const GelfandRow& gpr, F f);
+
+      // Merges k sorted tables src[i] shifted by weights shift[i] into a sorted table dst.
+      static void mergeShifted(const std::array<const U3WeightTable*, 4>& src, const std::array<U3Weight, 4>& shift,
+            size_t k, U3WeightTable& dst);
+
+#ifndef UNTOU3_DISABLE_PRECALC
+      // generates contributions of leaf rows of a shell for a given depth of precalculated rows
+      static void init_leaves(Shell& shell, size_t depth);
+#endif
+};
+
+template <typename T, typename U>
+void UNtoU3<T, U>::generateXYZ(int n)
+{
+   n_ = n;
+#ifndef UNTOU3_DISABLE_PRECALC
+   shell_ = getShell(n, precalc_depth_);
+#else
+   shell_ = getShell(n, 0);
+#endif
+}
+
+template <typename T, typename U>
+const typename UNtoU3<T, U>::Shell* UNtoU3<T, U>::getShell(int n, size_t depth)
+{
+   // shells are never released, pointers to them thus remain valid
+   static std::mutex mutex;
+   static std::map<std::pair<int, size_t>, std::unique_ptr<const Shell>> shells;
+   std::lock_guard<std::mutex> lock(mutex);
+
+   auto& shell = shells[{ n, depth }];
+   if (!shell) {
+      std::unique_ptr<Shell> temp(new Shell{});
+      auto& xyz = temp->xyz;
+      for (int k = 0; k <= n; k++) {
+         uint32_t nz = n - k;
+         for (int nx = k; nx >= 0; nx--) {
+            xyz[NX].push_back(nx);
+            xyz[NY].push_back(n - nz - nx);
+            xyz[NZ].push_back(nz);
+         }
+      }
+      for (int k = 0; k < 3; k++) {
+         temp->sorted[k] = xyz[k];
+         std::sort(temp->sorted[k].begin(), temp->sorted[k].end());
+      }
+
+#ifndef UNTOU3_DISABLE_PRECALC
+      init_leaves(*temp, depth);
+#endif
+#ifdef UNTOU3_ENABLE_DOMINANT
+      init_dominant(*temp);
+#endif
+      shell = std::move(temp);
+   }
+   return shell.get();
+}
+
+#ifdef UNTOU3_ENABLE_DOMINANT
+template <typename T, typename U>
+void UNtoU3<T, U>::init_dominant(Shell& shell)
+{
+   const auto& xyz = shell.xyz;
+   const size_t levels = xyz[0].size();
+   shell.dominant_ptr.resize(levels);
+
+   std::vector<int64_t> diffs;
+   for (int k = 0; k < 2; k++) {
+      diffs.clear();
+      for (size_t N = 0; N < levels; N++) {
+         // differences of HO states 0 to N sorted in descending order
+         diffs.insert(std::upper_bound(diffs.begin(), diffs.end(), (int64_t)xyz[k][N] - (int64_t)xyz[k + 1][N], 
+                  std::greater<int64_t>()), (int64_t)xyz[k][N] - (int64_t)xyz[k + 1][N]);
+         shell.dominant_ptr[N] = shell.dominant_sums[k].size();
+         shell.dominant_sums[k].push_back(0);
+         for (auto d : diffs) shell.dominant_sums[k].push_back(shell.dominant_sums[k].back() + d);
+      }
+   }
+}
+#endif
+
+template <typename T, typename U>
+void UNtoU3<T, U>::setPrecalcDepth(size_t depth)
+{
+#ifndef UNTOU3_DISABLE_PRECALC
+   precalc_depth_ = std::max<size_t>(depth, 1);
+   if (shell_) 
+      shell_ = getShell(n_, precalc_depth_);
+#else
+   (void)depth;
+#endif
+}
+
+template <typename T, typename U>
+typename UNtoU3<T, U>::U3WeightTable UNtoU3<T, U>::getIrreps(const U3MultMap& table)
+{
+   U3WeightTable irreps;
+
+#ifdef UNTOU3_ENABLE_DENSE
+
+   if (table.length() == 0) return irreps;
+   const auto& lo = table.lo();
+   const auto& hi = table.hi();
+   const T sum = table.sum();
+   const size_t stride = table.stride();
+
+   // Rows of the array (weights with the same first label) are copied into buffers padded by zeros on both sides.
+   // Level dimensionalities of a row are then evaluated from this and two following rows without any branches.
+   std::array<std::vector<U>, 3> rows;
+   auto load = [&](std::vector<U>& row, T l0) {
+      row.assign(stride + 2, 0);
+      if (l0 <= hi[0]) 
+         std::copy(table.data() + (l0 - lo[0]) * stride, table.data() + (l0 - lo[0] + 1) * stride, row.begin() + 1);
+   };
+   load(rows[0], lo[0]);
+   load(rows[1], lo[0] + 1);
+   std::vector<U> D_l(stride);
+
+   for (T l0 = lo[0]; l0 <= hi[0]; l0++) {
+      load(rows[2], l0 + 2);
+      const U* r0 = rows[0].data() + 1;
+      const U* r1 = rows[1].data() + 1;
+      const U* r2 = rows[2].data() + 1;
+
+      // weights of the row with f1 >= f2 >= f3
+      const T first = std::max<T>(lo[1], (sum - l0 + 1) / 2), last = std::min<T>(hi[1], l0);
+      if (first <= last) {
+         const size_t begin = first - lo[1], end = last - lo[1] + 1;
+         for (size_t j = begin; j < end; j++) 
+            D_l[j] = r0[j] + r1[j + 1] + r2[j - 1] - r2[j] - r1[j - 1] - r0[j + 1];
+         for (size_t j = begin; j < end; j++) 
+            if (D_l[j]) 
+               irreps.emplace_back(U3Weight{ l0, (T)(lo[1] + j), (T)(sum - l0 - lo[1] - j) }, D_l[j]);
+      }
+
+      std::swap(rows[0], rows[1]);
+      std::swap(rows[1], rows[2]);
+   }
+
+#else  /* UNTOU3_ENABLE_DENSE */
+
+   for (const auto& pair : table) 
+      if (auto D_l = getLevelDimensionality(table, pair.first)) 
+         irreps.emplace_back(pair.first, D_l);
+   std::sort(irreps.begin(), irreps.end());
+
+#endif /* UNTOU3_ENABLE_DENSE */
+
+   return irreps;
+}
+
+template <typename T, typename U>
+std::vector<typename UNtoU3<T, U>::U3MultMap> UNtoU3<T, U>::generateU3WeightsBatch(const std::vector<GelfandRow>& irreps)
+{
+   std::vector<U3MultMap> mults(irreps.size());
+   std::vector<GelfandRow> gprs;
+   std::vector<U3MultMap*> ptrs;
+   // irreps whose tables are generated and their positions, and positions of irreps derived from them
+   std::map<GelfandRow, size_t> generated;
+   std::vector<std::pair<size_t, size_t>> copies, complements;
+   for (size_t i = 0; i < irreps.size(); i++) {
+      const auto& f = irreps[i];
+      auto it = generated.find(f);
+      if (it != generated.end()) { copies.push_back({ i, it->second }); continue; }
+      it = generated.find(GelfandRow{ f[2], f[1], f[0] });
+      if (it != generated.end()) { complements.push_back({ i, it->second }); continue; }
+
+#ifdef UNTOU3_ENABLE_OVERFLOW_CHECK
+      checkBounds(f[0], f[1], f[2]);
+#endif
+      resetMult(mults[i], f[0], f[1], f[2]);
+      generated[f] = i;
+      gprs.push_back(f);
+      ptrs.push_back(&mults[i]);
+   }
+   generateU3WeightsMemo(gprs, ptrs);
+
+   for (const auto& c : copies) 
+      mults[c.first] = mults[c.second];
+   for (const auto& c : complements) {
+      const auto& f = irreps[c.second];
+      complementWeights(mults[c.second], mults[c.first], f[0], f[1], f[2]);
+   }
+   return mults;
+}
+
+template <typename T, typename U>
+template <typename Table>
+void UNtoU3<T, U>::complementWeights(const Table& src, U3MultMap& dst, uint16_t n2, uint16_t n1, uint16_t n0) const
+{
+   T Q2 = 0;
+   for (auto q : shell_->xyz[0]) Q2 += 2 * q;
+
+   resetMult(dst, n0, n1, n2);
+   for (const auto& pair : src) 
+      if (pair.second) 
+         dst[{ (T)(Q2 - pair.first[2]), (T)(Q2 - pair.first[1]), (T)(Q2 - pair.first[0]) }] += pair.second;
+}
+
+template <typename T, typename U>
+void UNtoU3<T, U>::complement(uint16_t n2, uint16_t n1, uint16_t n0)
+{
+   U3MultMap temp;
+   complementWeights(mult_, temp, n2, n1, n0);
+   std::swap(mult_, temp);
+   clearIndex();
+}
+
+template <typename T, typename U>
+void UNtoU3<T, U>::getWeightBounds(uint16_t n2, uint16_t n1, uint16_t, U3Weight& lo, U3Weight& hi) const
+{
+   for (int k = 0; k < 3; k++) {
+      // labels are maximal (minimal) when twos and then ones are assigned to the highest (lowest) quanta
+      const auto& q = shell_->sorted[k];
+      T l = 0, h = 0;
+      for (size_t i = 0; i < n2 + n1; i++) {
+         T w = (i < n2) ? 2 : 1;
+         l += w * q[i];
+         h += w * q[q.size() - 1 - i];
+      }
+      lo[k] = l; hi[k] = h;
+   }
+}
+
+template <typename T, typename U>
+long double UNtoU3<T, U>::maxMultiplicity(uint16_t n2, uint16_t n1, uint16_t n0)
+{
+   // [f] has two columns of lengths p and q, the cell in the row i and the column j has the content j-i and the hook
+   // length given by the number of cells to its right and below
+   const size_t N = n2 + n1 + n0, p = n2 + n1, q = n2;
+   long double dim = 1.0L;
+   for (size_t i = 1; i <= p; i++)
+      dim *= (long double)(N + 1 - i) / (p - i + 1 + (i <= q ? 1 : 0));
+   for (size_t i = 1; i <= q; i++)
+      dim *= (long double)(N + 2 - i) / (q - i + 1);
+   return dim * (1.0L + 1e-12L);
+}
+
+#ifdef UNTOU3_ENABLE_OVERFLOW_CHECK
+template <typename T, typename U>
+void UNtoU3<T, U>::checkBounds(uint16_t n2, uint16_t n1, uint16_t n0) const
+{
+   // std::numeric_limits is not specialized for extended integer types in strict modes
+   if (maxLabel(n_, n2, n1, n0) > (T)~(T)0)
+      throw std::overflow_error("UNtoU3: labels of U(3) weights might overflow T");
+   if (maxMultiplicity(n2, n1, n0) > (long double)(U)~(U)0)
+      throw std::overflow_error("UNtoU3: multiplicities of U(3) weights might overflow U");
+}
+#endif
+
+template <typename T, typename U>
+void UNtoU3<T, U>::resetMult(U3MultMap& mult, uint16_t n2, uint16_t n1, uint16_t n0) const
+{
+#ifdef UNTOU3_ENABLE_DENSE
+   U3Weight lo, hi;
+   getWeightBounds(n2, n1, n0, lo, hi);
+   mult.reshape(lo, hi, n_ * (2 * n2 + n1));
+#else
+   // buckets or slots are kept for the next generation
+   mult.clear();
+   reserveTable(mult, estimateSize(n2, n1, n0), 0);
+#endif
+}
+
+template <typename T, typename U>
+void UNtoU3<T, U>::addToDense(std::vector<U>& data, uint16_t n2, uint16_t n1, uint16_t n0) const
+{
+   U3Weight lo, hi;
+   getWeightBounds(n2, n1, n0, lo, hi);
+   const size_t stride = hi[1] - lo[1] + 1;
+   data.resize((hi[0] - lo[0] + 1) * stride, 0);
+   for (const auto& pair : mult_) 
+      data[(pair.first[0] - lo[0]) * stride + (pair.first[1] - lo[1])] += pair.second;
+}
+
+template <typename T, typename U>
+void UNtoU3<T, U>::resetFromDense(const std::vector<U>& data, uint16_t n2, uint16_t n1, uint16_t n0)
+{
+   U3Weight lo, hi;
+   getWeightBounds(n2, n1, n0, lo, hi);
+   const size_t stride = hi[1] - lo[1] + 1;
+   const T sum = (T)(n_ * (2 * n2 + n1));
+   resetMult(mult_, n2, n1, n0);
+   for (size_t pos = 0; pos < data.size(); pos++) 
+      if (data[pos]) {
+         const T l0 = (T)(lo[0] + pos / stride), l1 = (T)(lo[1] + pos % stride);
+         const U3Weight w{ l0, l1, (T)(sum - l0 - l1) };
+         if (recorded(w)) mult_[w] = data[pos];
+      }
+}
+
+template <typename T, typename U>
+size_t UNtoU3<T, U>::estimateSize(uint16_t n2, uint16_t n1, uint16_t n0) const
+{
+   U3Weight lo, hi;
+   getWeightBounds(n2, n1, n0, lo, hi);
+   const long double box = (long double)(hi[0] - lo[0] + 1) * (hi[1] - lo[1] + 1);
+   return (size_t)std::min(box, maxMultiplicity(n2, n1, n0));
+}
+
+template <typename T, typename U>
+void UNtoU3<T, U>::reserve(uint16_t n2, uint16_t n1, uint16_t n0)
+{
+   const size_t size = estimateSize(n2, n1, n0);
+   reserveTable(mult_, size, 0);
+#if defined(UNTOU3_ENABLE_OPENMP) || defined(UNTOU3_ENABLE_THREADS)
+   for (auto& mult_tl : mult_tl_) 
+      if (mult_tl) reserveTable(*mult_tl, size, 0);
+#endif
+}
+
+template <typename T, typename U>
+void UNtoU3<T, U>::countPatterns(uint16_t n2, uint16_t n1, uint16_t n0)
+{
+   const size_t N = n2 + n1 + n0;
+   patterns_n0_ = n0;
+   patterns_N_ = N;
+   patterns_.assign((n2 + 1) * (n0 + 1) * N, 0.0);
+
+   // the number of twos and zeros never increases in lower rows
+   for (size_t L = 0; L < N; L++) 
+      for (size_t a = 0; a <= n2; a++)
+         for (size_t c = 0; (c <= n0) && (a + c <= L + 1); c++) {
+            GelfandRow gpr{ (GRT)a, (GRT)(L + 1 - a - c), (GRT)c };
+            double count = (L == 0) ? 1.0 : 0.0;
+            if (L > 0) 
+               forEachLowerRow(gpr, [&](const GelfandRow& lgpr, GRT) { count += patterns(lgpr); });
+            patterns_[(a * (n0 + 1) + c) * N + L] = count;
+         }
+}
+
+#if defined(UNTOU3_ENABLE_OPENMP) || defined(UNTOU3_ENABLE_THREADS)
+template <typename T, typename U>
+void UNtoU3<T, U>::setupTasks(uint16_t n2, uint16_t n1, uint16_t n0, size_t threads)
+{
+   const GelfandRow gpr{ n2, n1, n0 };
+   const size_t Ntop = n2 + n1 + n0 - 1;
+
+   task_level_ = 0;
+   task_patterns_ = -1.0;
+   if (task_cutoff_ == TaskCutoff::DEPTH) {
+      auto depth = (size_t)std::max(task_cutoff_value_, 0.0);
+      task_level_ = (depth > Ntop) ? 0 : Ntop + 1 - depth;
+      return;
+   }
+
+   countPatterns(n2, n1, n0);
+   const double total = patterns(gpr);
+
+   if (task_cutoff_ == TaskCutoff::SUBTREE_SIZE) 
+      task_patterns_ = task_cutoff_value_;
+   else if (task_cutoff_ == TaskCutoff::TASKS_PER_THREAD) 
+      task_patterns_ = total / (std::max(task_cutoff_value_, 1.0) * (double)threads);
+   else {
+      // sampling pass: a subtree of at most 10^5 Gelfand patterns on the path of largest lower rows is generated serially
+      GelfandRow sample = gpr;
+      U3Weight pp{ 0, 0, 0 };
+      for (size_t N = Ntop; (N > 0) && (patterns(sample) > 1.0e5); N--) {
+         GelfandRow next{};
+         GRT dnext = 0;
+         double largest = 0.0;
+         forEachLowerRow(sample, [&](const GelfandRow& lgpr, GRT d) {
+            if (patterns(lgpr) > largest) { next = lgpr; dnext = d; largest = patterns(lgpr); }
+         });
+         for (int k = 0; k < 3; k++) pp[k] += dnext * shell_->xyz[k][N];
+         sample = next;
+      }
+
+      U3MultMap scratch;
+      resetMult(scratch, n2, n1, n0);
+      task_level_ = Ntop + 1; // no tasks are spawned by the sampling pass
+#ifdef UNTOU3_ENABLE_STATS
+      // (the sampling pass is not counted)
+      StatsScope unbound(nullptr);
+#endif
+      auto start = std::chrono::steady_clock::now();
+      generateU3WeightsRec(sample, pp, scratch);
+      std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+      double time_per_pattern = time.count() / patterns(sample);
+      task_level_ = 0;
+
+      // tasks of the required duration, but at least 4 tasks per thread
+      double duration = (task_cutoff_value_ > 0.0) ? task_cutoff_value_ : 1.0e-4;
+      task_patterns_ = std::min(duration / std::max(time_per_pattern, 1.0e-12), total / (4.0 * (double)threads));
+   }
+}
+
+template <typename T, typename U>
+void UNtoU3<T, U>::partitionStatic(uint16_t n2, uint16_t n1, uint16_t n0, size_t chunks)
+{
+   task_level_ = std::numeric_limits<size_t>::max(); // no tasks are spawned by chunks
+   countPatterns(n2, n1, n0);
+   frontier_ = roots_;
+   expandSubtrees(frontier_, static_depth_, std::numeric_limits<size_t>::max());
+   partitionSubtrees(frontier_, chunks, chunks_);
+}
+
+template <typename T, typename U>
+void UNtoU3<T, U>::generateChunk(size_t c, U3MultMap& mult)
+{
+   for (size_t i = chunks_[c]; i < chunks_[c + 1]; i++) 
+      generateU3WeightsRec(frontier_[i].first, frontier_[i].second, mult);
+}
+#endif /* UNTOU3_ENABLE_OPENMP || UNTOU3_ENABLE_THREADS */
+
+template <typename T, typename U>
+void UNtoU3<T, U>::expandSubtrees(std::vector<std::pair<GelfandRow, U3Weight>>& subtrees, size_t depth, size_t size) const
+{
+   std::vector<std::pair<GelfandRow, U3Weight>> next;
+   for (size_t level = 0; (level < depth) && (subtrees.size() < size); level++) {
+      next.clear();
+      bool expanded = false;
+      for (const auto& subtree : subtrees) {
+         const auto& gpr = subtree.first;
+         const auto& pp = subtree.second;
+         const size_t N = gpr[0] + gpr[1] + gpr[2] - 1;
+         if (N == 0) 
+            next.push_back(subtree);
+         else {
+            forEachLowerRow(gpr, [&](const GelfandRow& lgpr, GRT d) {
+               next.push_back({ lgpr, shifted(pp, d, N) });
+            });
+            expanded = true;
+         }
+      }
+      subtrees.swap(next);
+      if (!expanded) break;
+   }
+}
+
+template <typename T, typename U>
+void UNtoU3<T, U>::partitionSubtrees(const std::vector<std::pair<GelfandRow, U3Weight>>& subtrees, size_t chunks, 
+      std::vector<size_t>& bounds) const
+{
+   double total = 0.0;
+   for (const auto& subtree : subtrees) 
+      total += patterns(subtree.first);
+
+   // chunk c starts with the first subtree preceded by at least c/chunks of all Gelfand patterns
+   bounds.assign(chunks + 1, subtrees.size());
+   bounds[0] = 0;
+   double preceding = 0.0;
+   size_t c = 1;
+   for (size_t i = 0; i < subtrees.size(); i++) {
+      while ((c < chunks) && (preceding >= total * c / chunks)) 
+         bounds[c++] = i;
+      preceding += patterns(subtrees[i].first);
+   }
+}
+
+template <typename T, typename U>
+template <typename Table>
+U UNtoU3<T, U>::getLevelDimensionality(const Table& table, const U3Weight& labels)
+{
+   T f1 = labels[0], f2 = labels[1], f3 = labels[2];
+   if ((f1 < f2) || (f2 < f3)) return 0;
+
+   auto u3_mult = table.find({f1, f2, f3});
+   assert(u3_mult != table.end());
+   auto mult = u3_mult->second;
+
+   u3_mult = table.find({ (T)(f1 + 1), (T)(f2 + 1), (T)(f3 - 2) });
+   mult += (u3_mult == table.end()) ? 0 : u3_mult->second;
+
+   u3_mult = table.find({ (T)(f1 + 2), (T)(f2 - 1), (T)(f3 - 1) });
+   mult += (u3_mult == table.end()) ? 0 : u3_mult->second;
+
+   u3_mult = table.find({ (T)(f1 + 2), f2, (T)(f3 - 2) });
+   mult -= (u3_mult == table.end()) ? 0 : u3_mult->second;
+
+   u3_mult = table.find({ (T)(f1 + 1), (T)(f2 - 1), f3 });
+   mult -= (u3_mult == table.end()) ? 0 : u3_mult->second;
+
+   u3_mult = table.find({ f1, (T)(f2 + 1), (T)(f3 - 1) });
+   mult -= (u3_mult == table.end()) ? 0 : u3_mult->second;
+
+   return mult;
+}
+
+template <typename T, typename U>
+void UNtoU3<T, U>::finalize()
+{
+   const auto irreps = getIrreps();
+   clearIndex();
+   if (irreps.empty()) return;
+
+   // irreps sorted by (lambda, mu) 
+   std::vector<std::pair<std::pair<T, T>, U>> sorted;
+   sorted.reserve(irreps.size());
+   for (const auto& irrep : irreps) {
+      const auto& w = irrep.first;
+      sorted.push_back({ { (T)(w[0] - w[1]), (T)(w[1] - w[2]) }, irrep.second });
+   }
+   std::sort(sorted.begin(), sorted.end());
+
+   const auto& w = irreps[0].first;
+   irrep_sum_ = w[0] + w[1] + w[2];
+   irrep_ptr_.assign((size_t)sorted.back().first.first + 2, 0);
+   irrep_mu_.reserve(sorted.size());
+   irrep_dim_.reserve(sorted.size());
+   for (const auto& irrep : sorted) {
+      irrep_ptr_[irrep.first.first + 1]++;
+      irrep_mu_.push_back(irrep.first.second);
+      irrep_dim_.push_back(irrep.second);
+   }
+   for (size_t lambda = 1; lambda < irrep_ptr_.size(); lambda++) 
+      irrep_ptr_[lambda] += irrep_ptr_[lambda - 1];
+
+   // exact sum of dimensions dim(lambda, mu) = (lambda + 1) * (mu + 1) * (lambda + mu + 2) / 2 times level dimensionalities,
+   // partial sums of threads are added in any order
+#ifdef UNTOU3_ENABLE_OPENMP
+#pragma omp parallel
+#endif
+   {
+      untou3_bigint partial;
+#ifdef UNTOU3_ENABLE_OPENMP
+#pragma omp for schedule(static) nowait
+#endif
+      for (long i = 0; i < (long)sorted.size(); i++) {
+         const uint64_t lambda = sorted[i].first.first, mu = sorted[i].first.second;
+         auto term = untou3_bigint::from(sorted[i].second);
+         term.multiply(lambda + 1).multiply(mu + 1).multiply(lambda + mu + 2).divide(2);
+         partial += term;
+      }
+#ifdef UNTOU3_ENABLE_OPENMP
+#pragma omp critical (untou3_finalize)
+#endif
+      irrep_total_ += partial;
+   }
+}
+
+template <typename T, typename U>
+untou3_bigint UNtoU3<T, U>::dimension(uint16_t n2, uint16_t n1, uint16_t n0)
+{
+   // numerators N + content and hook lengths of cells of two columns of lengths p and q (see maxMultiplicity),
+   // the product of numerators is divisible by the product of all hook lengths and thus by them one by one
+   const size_t N = n2 + n1 + n0, p = n2 + n1, q = n2;
+   untou3_bigint dim = 1;
+   for (size_t i = 1; i <= p; i++) dim.multiply(N + 1 - i);
+   for (size_t i = 1; i <= q; i++) dim.multiply(N + 2 - i);
+   for (size_t i = 1; i <= p; i++) {
+      const auto rem = dim.divide((uint32_t)(p - i + 1 + (i <= q ? 1 : 0)));
+      assert(rem == 0);
+      (void)rem;
+   }
+   for (size_t i = 1; i <= q; i++) {
+      const auto rem = dim.divide((uint32_t)(q - i + 1));
+      assert(rem == 0);
+      (void)rem;
+   }
+   return dim;
+}
+
+template <typename T, typename U>
+void UNtoU3<T, U>::validate(uint16_t n2, uint16_t n1, uint16_t n0) const
+{
+   const auto dim = dimension(n2, n1, n0);
+   if (irrep_total_ != dim)
+      throw std::runtime_error("UNtoU3::validate: sum of dimensions of U(3) irreps " + irrep_total_.str() 
+            + " differs from dim[f] = " + dim.str());
+}
+
+template <typename T, typename U>
+U UNtoU3<T, U>::findLevelDimensionality(const U3Weight& labels) const
+{
+   if ((labels[0] < labels[1]) || (labels[1] < labels[2]) || (labels[0] + labels[1] + labels[2] != irrep_sum_)) return 0;
+   const size_t lambda = labels[0] - labels[1];
+   if (lambda + 1 >= irrep_ptr_.size()) return 0;
+
+   const T mu = labels[1] - labels[2];
+   const auto first = irrep_mu_.begin() + irrep_ptr_[lambda], last = irrep_mu_.begin() + irrep_ptr_[lambda + 1];
+   const auto it = std::lower_bound(first, last, mu);
+   return ((it != last) && (*it == mu)) ? irrep_dim_[it - irrep_mu_.begin()] : 0;
+}
+
+template <typename T, typename U>
+void UNtoU3<T, U>::generateU3Weights(uint16_t n2, uint16_t n1, uint16_t n0, Engine engine)
+{
+#ifdef UNTOU3_ENABLE_OVERFLOW_CHECK
+   checkBounds(n2, n1, n0);
+#endif
+   clearIndex();
+   resetMult(mult_, n2, n1, n0);
+
+   merge_time_ = 0.0;
+#ifdef UNTOU3_ENABLE_STATS
+   resetStats(0);
+#endif
+   if (engine != Engine::RECURSIVE) {
+      if (engine == Engine::MEMOIZED) 
+         generateU3WeightsMemo({ GelfandRow{ n2, n1, n0 } }, { &mult_ });
+      else 
+         generateU3WeightsGF(n2, n1, n0);
+#ifdef UNTOU3_ENABLE_STATS
+      collectStats();
+#endif
+      return;
+   }
+
+#if !defined(UNTOU3_DISABLE_PRECALC) && defined(UNTOU3_ENABLE_DENSE)
+   init_leaf_offsets();
+#endif
+
+   roots_.assign(1, { GelfandRow{ n2, n1, n0 }, U3Weight{ 0, 0, 0 } });
+#ifdef UNTOU3_ENABLE_MPI
+   if (comm_ != MPI_COMM_NULL) {
+      distributeRoots(n2, n1, n0);
+      generateRoots(n2, n1, n0);
+      reduceRanks(n2, n1, n0);
+#ifdef UNTOU3_ENABLE_STATS
+      collectStats();
+#endif
+      return;
+   }
+#endif
+   generateRoots(n2, n1, n0);
+#ifdef UNTOU3_ENABLE_STATS
+   collectStats();
+#endif
+}
+
+#ifdef UNTOU3_ENABLE_THREADS
+template <typename T, typename U>
+untou3_future<typename UNtoU3<T, U>::U3MultMap> UNtoU3<T, U>::generateU3WeightsAsync(uint16_t n2, uint16_t n1, uint16_t n0, 
+      int threads, Engine engine)
+{
+   // the flag is shared by the handle and the generating thread, either of them may be destroyed first
+   std::shared_ptr<std::atomic<bool>> cancelled(new std::atomic<bool>(false));
+   auto future = std::async(std::launch::async, [=]() -> const U3MultMap* {
+#ifdef UNTOU3_ENABLE_OPENMP
+      // (OpenMP settings of the new thread do not affect the calling one)
+      omp_set_num_threads(std::max(threads, 1));
+#else
+      (void)threads;
+#endif
+#ifdef UNTOU3_ENABLE_MPI
+      const MPI_Comm comm = comm_;
+      comm_ = MPI_COMM_NULL;
+#endif
+      cancel_ = cancelled.get();
+      try {
+         generateU3Weights(n2, n1, n0, engine);
+      }
+      catch (...) {
+         cancel_ = nullptr;
+#ifdef UNTOU3_ENABLE_MPI
+         comm_ = comm;
+#endif
+         throw;
+      }
+      cancel_ = nullptr;
+#ifdef UNTOU3_ENABLE_MPI
+      comm_ = comm;
+#endif
+
+      if (cancelled->load()) {
+         resetMult(mult_, n2, n1, n0);
+         throw untou3_cancelled();
+      }
+      return &mult_;
+   });
+   return untou3_future<U3MultMap>(std::move(future), cancelled);
+}
+#endif /* UNTOU3_ENABLE_THREADS */
+
+#ifdef UNTOU3_ENABLE_MPI
+template <typename T, typename U>
+void UNtoU3<T, U>::distributeRoots(uint16_t n2, uint16_t n1, uint16_t n0)
+{
+   int rank = 0, size = 1;
+   MPI_Comm_rank(comm_, &rank);
+   MPI_Comm_size(comm_, &size);
+   if (size == 1) return;
+
+   // many more subtrees than ranks, such that their shares have similar numbers of Gelfand patterns
+   countPatterns(n2, n1, n0);
+   expandSubtrees(roots_, std::numeric_limits<size_t>::max(), 64 * (size_t)size);
+   std::vector<size_t> bounds;
+   partitionSubtrees(roots_, size, bounds);
+   roots_.erase(roots_.begin() + bounds[rank + 1], roots_.end());
+   roots_.erase(roots_.begin(), roots_.begin() + bounds[rank]);
+}
+
+template <typename T, typename U>
+void UNtoU3<T, U>::reduceRanks(uint16_t n2, uint16_t n1, uint16_t n0)
+{
+   if (ranks() == 1) return;
+
+#ifdef UNTOU3_ENABLE_DENSE
+   (void)n2; (void)n1; (void)n0;
+   untou3_mpi_allreduce_sum(mult_.data(), mult_.length(), comm_);
+#else
+   std::vector<U> data;
+   addToDense(data, n2, n1, n0);
+   untou3_mpi_allreduce_sum(data.data(), data.size(), comm_);
+   resetFromDense(data, n2, n1, n0);
+#endif
+}
+#endif /* UNTOU3_ENABLE_MPI */
+
+template <typename T, typename U>
+void UNtoU3<T, U>::generateRoots(uint16_t n2, uint16_t n1, uint16_t n0)
+{
+#ifdef UNTOU3_ENABLE_THREADS
+   if (executor_) {
+      generateU3WeightsExec(n2, n1, n0);
+      return;
+   }
+#endif
+
+#ifdef UNTOU3_ENABLE_OFFLOAD
+   if (offloaded(n2, n1, n0)) {
+      generateOffload(n2, n1, n0);
+      return;
+   }
+#endif
+   
+#ifdef UNTOU3_ENABLE_OPENMP
+
+   if (static_depth_ == 0) 
+      setupTasks(n2, n1, n0, omp_get_max_threads() * ranks());
+
+   double merge_start = 0.0;
+#pragma omp parallel
+   {
+      // the team may be larger than in previous calls
+#pragma omp single
+      {
+         const size_t nt = omp_get_num_threads();
+         if (mult_tl_.size() < nt) 
+            mult_tl_.resize(nt);
+#ifdef UNTOU3_ENABLE_NUMA
+         numa_tl_.resize(mult_tl_.size(), -1);
+#endif
+         if (static_depth_ > 0) 
+            partitionStatic(n2, n1, n0, nt);
+#ifdef UNTOU3_ENABLE_STATS
+         resetStats(nt);
+#endif
+      }
+
+      // each thread prepares its own table, the barrier below makes sure that no task is executed before
+#ifdef UNTOU3_ENABLE_NUMA
+      placeNuma();
+#endif
+      auto& mult_tl = mult_tl_[omp_get_thread_num()];
+      if (!mult_tl) 
+         mult_tl.reset(new U3MultMap{});
+      resetMult(*mult_tl, n2, n1, n0);
+#ifdef UNTOU3_ENABLE_STATS
+      StatsScope bound(bindStats(omp_get_thread_num(), *mult_tl));
+#endif
+#pragma omp barrier
+      if (static_depth_ > 0) {
+         generateChunk(omp_get_thread_num(), *mult_tl);
+#pragma omp barrier
+      }
+      else {
+#pragma omp single
+         for (const auto& root : roots_) 
+            generateU3WeightsRec(root.first, root.second, *mult_tl);
+      }
+
+#pragma omp master
+      merge_start = omp_get_wtime();
+      mergeThreadLocal();
+   }
+
+   // the table of thread 0 becomes the resulting table, the original one is reused as a thread-local table next time
+   std::swap(mult_, *mult_tl_[0]);
+   merge_time_ = omp_get_wtime() - merge_start;
+
+#else  /* UNTOU3_ENABLE_OPENMP */
+
+   (void)n2; (void)n1; (void)n0;
+   task_level_ = std::numeric_limits<size_t>::max(); // no subtrees are split
+#ifdef UNTOU3_ENABLE_STATS
+   resetStats(1);
+   StatsScope bound(bindStats(0, mult_));
+#endif
+   for (const auto& root : roots_) 
+      generateU3WeightsRec(root.first, root.second, mult_);
+
+#endif /* UNTOU3_ENABLE_OPENMP */
+}
+
+#ifdef UNTOU3_ENABLE_OFFLOAD
+template <typename T, typename U>
+bool UNtoU3<T, U>::offloaded(uint16_t n2, uint16_t n1, uint16_t n0)
+{
+   if ((offload_device_ < 0) || 
+         ((offload_device_ >= omp_get_num_devices()) && (offload_device_ != omp_get_initial_device()))) 
+      return false;
+   // (all MPI ranks decide by the whole tree)
+   countPatterns(n2, n1, n0);
+   return patterns(GelfandRow{ n2, n1, n0 }) >= (double)offload_subtrees_;
+}
+
+template <typename T, typename U>
+void UNtoU3<T, U>::generateOffload(uint16_t n2, uint16_t n1, uint16_t n0)
+{
+   // (an MPI rank may have no share of a small tree)
+   if (roots_.empty()) return;
+
+#ifndef UNTOU3_DISABLE_PRECALC
+   const size_t L = shell_->leaf_level;
+#else
+   const size_t L = 1; // rows of level 0 are leaves
+#endif
+
+   // subtrees need to fit into stacks of the device, and there need to be enough of them to occupy it
+   // (rows of roots_ have the same level, leaf rows are not expanded by the host)
+   const size_t Ntop = n2 + n1 + n0 - 1;
+   if (Ntop >= offload_levels) 
+      expandSubtrees(roots_, Ntop + 1 - offload_levels, std::numeric_limits<size_t>::max());
+   const size_t Nroots = roots_[0].first[0] + roots_[0].first[1] + roots_[0].first[2] - 1;
+   if (Nroots >= L) 
+      expandSubtrees(roots_, Nroots + 1 - L, offload_subtrees_);
+
+   // arrays of subtrees, HO quanta vectors, and leaf tables mapped to the device
+   const size_t count = roots_.size();
+   std::vector<GRT> rows(3 * count);
+   std::vector<T> pps(3 * count);
+   for (size_t i = 0; i < count; i++) 
+      for (int k = 0; k < 3; k++) {
+         rows[3 * i + k] = roots_[i].first[k];
+         pps[3 * i + k] = roots_[i].second[k];
+      }
+   const GRT* r = rows.data();
+   const T* p = pps.data();
+   // (third labels of weights are implied by their sum)
+   const size_t levels = shell_->xyz[0].size();
+   const uint32_t* x0 = shell_->xyz[0].data();
+   const uint32_t* x1 = shell_->xyz[1].data();
+#ifndef UNTOU3_DISABLE_PRECALC
+   const uint32_t* leaf_ptr = shell_->leaf_ptr.data();
+   const T* leaf_weights = shell_->leaf_weights.data();
+   const U* leaf_counts = shell_->leaf_counts.data();
+   const size_t leaves = shell_->leaf_counts.size(), leaf_rows = shell_->leaf_ptr.size();
+#else
+   const uint32_t* leaf_ptr = nullptr;
+   const T* leaf_weights = nullptr;
+   const U* leaf_counts = nullptr;
+   const size_t leaves = 0, leaf_rows = 0;
+#endif
+
+   // dense array of multiplicities of weights indexed by first two labels
+   U3Weight lo, hi;
+   getWeightBounds(n2, n1, n0, lo, hi);
+   const T lo0 = lo[0], lo1 = lo[1];
+   const size_t stride = hi[1] - lo[1] + 1;
+#ifdef UNTOU3_ENABLE_DOMINANT
+   const T sum = (T)(n_ * (2 * n2 + n1));
+#endif
+#ifdef UNTOU3_ENABLE_DENSE
+   U* hist = mult_.data();
+   const size_t length = mult_.length();
+#else
+   std::vector<U> data((hi[0] - lo[0] + 1) * stride, 0);
+   U* hist = data.data();
+   const size_t length = data.size();
+#endif
+
+#pragma omp target teams distribute parallel for schedule(dynamic, 1) device(offload_device_) \
+   map(to: r[0:3 * count], p[0:3 * count], x0[0:levels], x1[0:levels]) \
+   map(to: leaf_ptr[0:leaf_rows], leaf_weights[0:3 * leaves], leaf_counts[0:leaves]) map(tofrom: hist[0:length])
+   for (size_t i = 0; i < count; i++) {
+      // stack of rows of the subtree (the row at position s is of level N0 - s), partial contributions 
+      // of higher rows to weights, and indexes of lower rows to be visited next (see forEachLowerRow)
+      GRT a[offload_levels], b[offload_levels], c[offload_levels];
+      T w0[offload_levels], w1[offload_levels];
+      unsigned char next[offload_levels];
+
+      const size_t N0 = r[3 * i] + r[3 * i + 1] + r[3 * i + 2] - 1;
+      a[0] = r[3 * i]; b[0] = r[3 * i + 1]; c[0] = r[3 * i + 2];
+      w0[0] = p[3 * i]; w1[0] = p[3 * i + 1];
+      next[0] = 0;
+
+      size_t s = 0;
+      while (true) {
+         const size_t N = N0 - s;
+         bool pop = false;
+
+         if (N < L) {
+            // leaf row
+#ifndef UNTOU3_DISABLE_PRECALC
+            const size_t l = (a[s] * (L + 1) + b[s]) * (L + 1) + c[s];
+            for (size_t j = leaf_ptr[l]; j < leaf_ptr[l + 1]; j++) {
+               const size_t pos = (size_t)(T)(w0[s] + leaf_weights[3 * j] - lo0) * stride 
+                  + (size_t)(T)(w1[s] + leaf_weights[3 * j + 1] - lo1);
+#ifdef UNTOU3_ENABLE_DOMINANT
+               // (see recorded)
+               const T l0 = (T)(w0[s] + leaf_weights[3 * j]), l1 = (T)(w1[s] + leaf_weights[3 * j + 1]);
+               if ((l0 + 1 < l1) || (l1 + 1 < (T)(sum - l0 - l1))) continue;
+#endif
+#pragma omp atomic update
+               hist[pos] += leaf_counts[j];
+            }
+#else
+            const T d = (T)(2 * a[s] + b[s]);
+            const size_t pos = (size_t)(T)(w0[s] + d * x0[0] - lo0) * stride + (size_t)(T)(w1[s] + d * x1[0] - lo1);
+#ifdef UNTOU3_ENABLE_DOMINANT
+            const T l0 = (T)(w0[s] + d * x0[0]), l1 = (T)(w1[s] + d * x1[0]);
+            if ((l0 + 1 >= l1) && (l1 + 1 >= (T)(sum - l0 - l1)))
+#endif
+            {
+#pragma omp atomic update
+               hist[pos] += 1;
+            }
+#endif
+            pop = true;
+         }
+         else {
+            // next lower row, if any
+            GRT la = a[s], lb = b[s], lc = c[s], d = 0;
+            bool found = false;
+            while (!found && (next[s] < 4)) {
+               switch (next[s]++) {
+                  case 0: if (a[s]) { la = (GRT)(a[s] - 1); d = 2; found = true; } break;
+                  case 1: if (a[s] && c[s]) { la = (GRT)(a[s] - 1); lb = (GRT)(b[s] + 1); lc = (GRT)(c[s] - 1); d = 1; found = true; } break;
+                  case 2: if (b[s]) { lb = (GRT)(b[s] - 1); d = 1; found = true; } break;
+                  case 3: if (c[s]) { lc = (GRT)(c[s] - 1); d = 0; found = true; } break;
+               }
+            }
+            if (found) {
+               a[s + 1] = la; b[s + 1] = lb; c[s + 1] = lc;
+               w0[s + 1] = (T)(w0[s] + d * x0[N]); 
+               w1[s + 1] = (T)(w1[s] + d * x1[N]);
+               next[++s] = 0;
+            }
+            else 
+               pop = true;
+         }
+
+         if (pop) {
+            if (s == 0) break;
+            s--;
+         }
+      }
+   }
+
+#ifndef UNTOU3_ENABLE_DENSE
+   resetFromDense(data, n2, n1, n0);
+#endif
+}
+#endif /* UNTOU3_ENABLE_OFFLOAD */
+
+#ifdef UNTOU3_ENABLE_OPENMP
+template <typename T, typename U>
+void UNtoU3<T, U>::mergeThreadLocal()
+{
+   const size_t nt = omp_get_num_threads(), tid = omp_get_thread_num();
+#ifdef UNTOU3_ENABLE_STATS
+   const double merge_start = omp_get_wtime();
+#endif
+
+#ifdef UNTOU3_ENABLE_NUMA
+
+#pragma omp single
+   orderNuma(nt);
+
+   const size_t pos = std::find(numa_order_.begin(), numa_order_.begin() + nt, tid) - numa_order_.begin();
+#ifdef UNTOU3_ENABLE_DENSE
+   // tables of each node are merged into the table of its first thread by threads of that node 
+   const size_t node = std::upper_bound(numa_begin_.begin(), numa_begin_.end(), pos) - numa_begin_.begin() - 1;
+   const size_t first = numa_begin_[node], threads = numa_begin_[node + 1] - first;
+   auto& node_dst = *mult_tl_[numa_order_[first]];
+   const size_t node_length = node_dst.length();
+   const size_t node_begin = node_length * (pos - first) / threads, node_end = node_length * (pos - first + 1) / threads;
+   for (size_t t = first + 1; t < first + threads; t++) 
+      node_dst.merge(*mult_tl_[numa_order_[t]], node_begin, node_end);
+#pragma omp barrier
+
+   // only these tables are then read across nodes
+   if (numa_begin_.size() > 2) {
+      auto& dst = *mult_tl_[0];
+      const size_t length = dst.length();
+      const size_t begin = length * tid / nt, end = length * (tid + 1) / nt;
+      for (size_t n = 1; n + 1 < numa_begin_.size(); n++) 
+         dst.merge(*mult_tl_[numa_order_[numa_begin_[n]]], begin, end);
+#pragma omp barrier
+   }
+
+#else  /* UNTOU3_ENABLE_DENSE */
+
+   // the tree reduction over threads ordered by nodes merges tables of the same node first
+   for (size_t stride = 1; stride < nt; stride *= 2) {
+      if ((pos % (2 * stride) == 0) && (pos + stride < nt)) {
+         auto& dst = *mult_tl_[tid];
+         for (const auto& temp : *mult_tl_[numa_order_[pos + stride]])
+            dst[temp.first] += temp.second;
+      }
+#pragma omp barrier
+   }
+
+#endif /* UNTOU3_ENABLE_DENSE */
+
+#else  /* UNTOU3_ENABLE_NUMA */
+
+#ifdef UNTOU3_ENABLE_DENSE
+   auto& dst = *mult_tl_[0];
+   const size_t length = dst.length();
+   const size_t begin = length * tid / nt, end = length * (tid + 1) / nt;
+   for (size_t t = 1; t < nt; t++) 
+      dst.merge(*mult_tl_[t], begin, end);
+#pragma omp barrier
+
+#else  /* UNTOU3_ENABLE_DENSE */
+
+   for (size_t stride = 1; stride < nt; stride *= 2) {
+      if ((tid % (2 * stride) == 0) && (tid + stride < nt)) {
+         auto& dst = *mult_tl_[tid];
+         for (const auto& temp : *mult_tl_[tid + stride])
+            dst[temp.first] += temp.second;
+      }
+#pragma omp barrier
+   }
+
+#endif /* UNTOU3_ENABLE_DENSE */
+
+#endif /* UNTOU3_ENABLE_NUMA */
+
+#ifdef UNTOU3_ENABLE_STATS
+   // (generators of other labels merge their tables without statistics)
+   if (tid < stats_threads_) 
+      stats_tl_[tid]->merge_time += omp_get_wtime() - merge_start;
+#endif
+}
+#endif /* UNTOU3_ENABLE_OPENMP */
+
+#ifdef UNTOU3_ENABLE_NUMA
+template <typename T, typename U>
+int UNtoU3<T, U>::numaNode()
+{
+   unsigned cpu = 0, node = 0;
+   if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) 
+      return 0;
+   return (int)node;
+}
+
+template <typename T, typename U>
+void UNtoU3<T, U>::placeNuma()
+{
+   const size_t tid = omp_get_thread_num();
+   const int node = numaNode();
+   // (pages of a reused table stay where they were first touched)
+   if (numa_tl_[tid] != node) 
+      mult_tl_[tid].reset();
+   numa_tl_[tid] = node;
+}
+
+template <typename T, typename U>
+void UNtoU3<T, U>::orderNuma(size_t nt)
+{
+   numa_order_.resize(nt);
+   for (size_t t = 0; t < nt; t++) 
+      numa_order_[t] = t;
+   const int node_0 = numa_tl_[0];
+   std::stable_sort(numa_order_.begin(), numa_order_.end(), [&](size_t a, size_t b) {
+      return std::make_pair(numa_tl_[a] != node_0, numa_tl_[a]) < std::make_pair(numa_tl_[b] != node_0, numa_tl_[b]);
+   });
+
+   numa_begin_.assign(1, 0);
+   for (size_t t = 1; t < nt; t++) 
+      if (numa_tl_[numa_order_[t]] != numa_tl_[numa_order_[t - 1]]) 
+         numa_begin_.push_back(t);
+   numa_begin_.push_back(nt);
+}
+#endif /* UNTOU3_ENABLE_NUMA */
+
+#ifdef UNTOU3_ENABLE_THREADS
+template <typename T, typename U>
+void UNtoU3<T, U>::generateU3WeightsExec(uint16_t n2, uint16_t n1, uint16_t n0)
+{
+   const size_t nw = std::max<size_t>(executor_->concurrency(), 1);
+   if (static_depth_ > 0) 
+      partitionStatic(n2, n1, n0, nw);
+   else
+      setupTasks(n2, n1, n0, nw * ranks());
+
+   if (mult_tl_.size() < nw) 
+      mult_tl_.resize(nw);
+
+   // the whole tree (subtrees of roots_) is initially in the queue of worker 0
+   std::atomic<size_t> pending{ roots_.size() };
+   std::atomic<bool> abort{ false };
+   std::vector<WorkQueue> queues(nw);
+   for (auto& queue : queues) {
+      queue.pending = &pending;
+      queue.abort = &abort;
+   }
+   queues[0].subtrees.assign(roots_.begin(), roots_.end());
+
+#ifdef UNTOU3_ENABLE_STATS
+   resetStats(nw);
+#endif
+   executor_->parallel([&](size_t w) {
+      auto& mult_tl = mult_tl_[w];
+      if (!mult_tl) 
+         mult_tl.reset(new U3MultMap{});
+      resetMult(*mult_tl, n2, n1, n0);
+#ifdef UNTOU3_ENABLE_STATS
+      StatsScope bound(bindStats(w, *mult_tl));
+#endif
+      if (static_depth_ > 0) 
+         generateChunk(w, *mult_tl);
+      else
+         runWorker(queues, w);
+   });
+
+   auto merge_start = std::chrono::steady_clock::now();
+   mergeWorkers(nw);
+   std::swap(mult_, *mult_tl_[0]);
+   std::chrono::duration<double> merge_time = std::chrono::steady_clock::now() - merge_start;
+   merge_time_ = merge_time.count();
+}
+
+template <typename T, typename U>
+void UNtoU3<T, U>::runWorker(std::vector<WorkQueue>& queues, size_t w)
+{
+   const size_t nw = queues.size();
+   auto& queue = queues[w];
+   auto& mult = *mult_tl_[w];
+
+   std::pair<GelfandRow, U3Weight> subtree;
+   auto pop = [&](WorkQueue& q, bool back) {
+      std::lock_guard<std::mutex> lock(q.mutex);
+      if (q.subtrees.empty()) return false;
+      if (back) { subtree = q.subtrees.back(); q.subtrees.pop_back(); }
+      else { subtree = q.subtrees.front(); q.subtrees.pop_front(); }
+      return true;
+   };
+
+   while ((queue.pending->load() > 0) && !queue.abort->load()) {
+      // own (smallest) subtrees first, then steal the largest ones of other workers
+      bool found = pop(queue, true);
+      for (size_t v = 1; !found && (v < nw); v++) 
+         found = pop(queues[(w + v) % nw], false);
+
+      if (found) {
+         try {
+            generateU3WeightsRec(subtree.first, subtree.second, mult, &queue);
+         }
+         catch (...) {
+            // subtrees of the failed one would never be generated, the exception is rethrown by the executor 
+            // after all workers return
+            queue.abort->store(true);
+            queue.pending->fetch_sub(1);
+            throw;
+         }
+         queue.pending->fetch_sub(1);
+      }
+      else 
+         std::this_thread::yield();
+   }
+}
+
+template <typename T, typename U>
+void UNtoU3<T, U>::pushLowerRows(const GelfandRow& gpr, const U3Weight& pp, size_t N, WorkQueue& queue) const
+{
+   std::lock_guard<std::mutex> lock(queue.mutex);
+   forEachLowerRow(gpr, [&](const GelfandRow& lgpr, GRT d) {
+      queue.pending->fetch_add(1);
+      queue.subtrees.push_back({ lgpr, shifted(pp, d, N) });
+   });
+}
+
+template <typename T, typename U>
+void UNtoU3<T, U>::mergeWorkers(size_t nw)
+{
+#ifdef UNTOU3_ENABLE_DENSE
+   // each worker merges a range of positions of all tables
+   auto& dst = *mult_tl_[0];
+   const size_t length = dst.length();
+   executor_->parallel([&](size_t w) {
+#ifdef UNTOU3_ENABLE_STATS
+      const auto start = std::chrono::steady_clock::now();
+#endif
+      const size_t begin = length * w / nw, end = length * (w + 1) / nw;
+      for (size_t t = 1; t < nw; t++) 
+         dst.merge(*mult_tl_[t], begin, end);
+#ifdef UNTOU3_ENABLE_STATS
+      stats_tl_[w]->merge_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+#endif
+   });
+#else  /* UNTOU3_ENABLE_DENSE */
+   // pairwise tree reduction, one call of the executor per round
+   for (size_t stride = 1; stride < nw; stride *= 2) 
+      executor_->parallel([&](size_t w) {
+         if ((w % (2 * stride) == 0) && (w + stride < nw)) {
+#ifdef UNTOU3_ENABLE_STATS
+            const auto start = std::chrono::steady_clock::now();
+#endif
+            auto& dst = *mult_tl_[w];
+            for (const auto& temp : *mult_tl_[w + stride])
+               dst[temp.first] += temp.second;
+#ifdef UNTOU3_ENABLE_STATS
+            stats_tl_[w]->merge_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+#endif
+         }
+      });
+#endif /* UNTOU3_ENABLE_DENSE */
+}
+#endif /* UNTOU3_ENABLE_THREADS */
+
+#ifdef UNTOU3_ENABLE_STATS
+template <typename T, typename U>
+thread_local untou3_thread_stats* UNtoU3<T, U>::thread_stats_ = nullptr;
+
+template <typename T, typename U>
+void UNtoU3<T, U>::resetStats(size_t threads)
+{
+   if (stats_tl_.size() < threads) 
+      stats_tl_.resize(threads);
+   for (size_t t = 0; t < threads; t++) {
+      if (!stats_tl_[t]) 
+         stats_tl_[t].reset(new untou3_thread_stats{});
+      // (the allocated histogram is kept)
+      std::vector<uint64_t> leaf_hits;
+      leaf_hits.swap(stats_tl_[t]->leaf_hits);
+      *stats_tl_[t] = untou3_thread_stats{};
+#ifndef UNTOU3_DISABLE_PRECALC
+      leaf_hits.assign(shell_->leaf_level, 0);
+#endif
+      stats_tl_[t]->leaf_hits.swap(leaf_hits);
+   }
+   stats_threads_ = threads;
+}
+
+template <typename T, typename U>
+void UNtoU3<T, U>::collectStats()
+{
+   stats_ = untou3_stats{};
+#ifndef UNTOU3_DISABLE_PRECALC
+   stats_.leaf_hits.assign(shell_->leaf_level, 0);
+#endif
+   for (size_t t = 0; t < stats_threads_; t++) {
+      const auto& ts = *stats_tl_[t];
+      stats_.rows += ts.rows;
+      stats_.patterns += ts.patterns;
+      for (size_t N = 0; N < ts.leaf_hits.size(); N++) 
+         stats_.leaf_hits[N] += ts.leaf_hits[N];
+      stats_.tasks_spawned += ts.tasks_spawned;
+      stats_.tasks_inlined += ts.tasks_inlined;
+      stats_.rehashes += ts.rehashes;
+      stats_.busy_time.push_back(ts.busy_time);
+      stats_.merge_time.push_back(ts.merge_time);
+   }
+   stats_.table_size = mult_.size();
+   stats_.table_capacity = tableCapacity(mult_, 0);
+}
+
+template <typename T, typename U>
+void UNtoU3<T, U>::countRow(const GelfandRow& gpr, bool spawn, bool queued)
+{
+   untou3_thread_stats* stats = thread_stats_;
+   if (!stats) return;
+
+   stats->rows++;
+   const uint64_t lower = (gpr[0] ? 1 : 0) + ((gpr[0] && gpr[2]) ? 1 : 0) + (gpr[1] ? 1 : 0) + (gpr[2] ? 1 : 0);
+   // with tail call elimination, the last lower row is generated by the next iteration (unless pushed into a queue)
+#ifndef UNTOU3_DISABLE_TCE
+   const uint64_t iterated = (spawn && queued) ? 0 : 1;
+#else
+   (void)queued;
+   const uint64_t iterated = 0;
+#endif
+   if (spawn) {
+      stats->tasks_spawned += lower - iterated;
+      stats->tasks_inlined += iterated;
+   }
+   else 
+      stats->tasks_inlined += lower;
+}
+
+template <typename T, typename U>
+void UNtoU3<T, U>::countLeaf(size_t N, uint64_t count, const U3MultMap& mult)
+{
+   untou3_thread_stats* stats = thread_stats_;
+   if (!stats) return;
+
+   stats->patterns += count;
+   if (N < stats->leaf_hits.size()) 
+      stats->leaf_hits[N]++;
+   const size_t capacity = tableCapacity(mult, 0);
+   if (capacity != stats->capacity) {
+      stats->rehashes++;
+      stats->capacity = capacity;
+   }
+}
+#endif /* UNTOU3_ENABLE_STATS */
+
+template <typename T, typename U>
+void UNtoU3<T, U>::generateU3WeightsRec(GelfandRow gpr, U3Weight pp, U3MultMap& mult, WorkQueue* queue) 
+{
+   size_t N = gpr[0] + gpr[1] + gpr[2] - 1;
+   U3MultMap* pmult = &mult;
+#ifdef UNTOU3_ENABLE_STATS
+   untou3_busy_scope busy(thread_stats_);
+#endif
+
+#ifndef UNTOU3_DISABLE_TCE
+   while
+#else
+   if
+#endif
+#ifndef UNTOU3_DISABLE_PRECALC
+   (N >= shell_->leaf_level)
+#else 
+   (N > 0)
+#endif 
+   {
+#ifdef UNTOU3_ENABLE_DOMINANT
+       if (!reachesDominant(gpr, pp, N)) return;
+#endif
+       if (cancelled()) return;
+       const bool spawn = spawnTasks(gpr, N);
+#ifdef UNTOU3_ENABLE_STATS
+       // (without OpenMP, only subtrees pushed into queues are split)
+#ifdef UNTOU3_ENABLE_OPENMP
+       countRow(gpr, spawn, spawn && queue);
+#else
+       countRow(gpr, spawn && queue, spawn && queue);
+#endif
+#endif
+#ifdef UNTOU3_ENABLE_THREADS
+       // the subtree is split into the work-stealing queue of the executing worker
+       if (spawn && queue) {
+          pushLowerRows(gpr, pp, N, *queue);
+          return;
+       }
+#endif
+
+       if (gpr[0]) {
+           if (gpr[1] || gpr[2]) {
+#ifdef UNTOU3_ENABLE_OPENMP
+#pragma omp task if (spawn) firstprivate(gpr, pp)
+#endif
+               generateU3WeightsRec( { (GRT)(gpr[0] - 1), gpr[1], gpr[2] }, 
+                       shifted(pp, 2, N), taskMult(spawn, pmult), queue);
+               if (gpr[2]) 
+#ifdef UNTOU3_ENABLE_OPENMP
+#pragma omp task if (spawn) firstprivate(gpr, pp)
+#endif
+                   generateU3WeightsRec( { (GRT)(gpr[0] - 1), (GRT)(gpr[1] + 1), (GRT)(gpr[2] - 1) },
+                           shifted(pp, 1, N), taskMult(spawn, pmult), queue);
+           }
+           else {
+#ifndef UNTOU3_DISABLE_TCE
+               gpr[0]--;
+               pp[0] += 2 * shell_->xyz[0][N]; pp[1] += 2 * shell_->xyz[1][N]; pp[2] += 2 * shell_->xyz[2][N];
+#else /* UNTOU3_DISABLE_TCE */
+#ifdef UNTOU3_ENABLE_OPENMP
+#pragma omp task if (spawn) firstprivate(gpr, pp)
+#endif
+               generateU3WeightsRec( { (GRT)(gpr[0] - 1), gpr[1], gpr[2] }, 
+                       shifted(pp, 2, N), taskMult(spawn, pmult), queue);
+#endif /* UNTOU3_DISABLE_TCE */
+           }
+       }
+
+       if (gpr[1]) 
+           if (gpr[2])
+#ifdef UNTOU3_ENABLE_OPENMP
+#pragma omp task if (spawn) firstprivate(gpr, pp)
+#endif
+               generateU3WeightsRec( { gpr[0], (GRT)(gpr[1] - 1), gpr[2] },
+                       shifted(pp, 1, N), taskMult(spawn, pmult), queue);
+           else {
+#ifndef UNTOU3_DISABLE_TCE
+              gpr[1]--; 
+              pp[0] += shell_->xyz[0][N]; pp[1] += shell_->xyz[1][N]; pp[2] += shell_->xyz[2][N];
+#else /* UNTOU3_DISABLE_TCE */
+#ifdef UNTOU3_ENABLE_OPENMP
+#pragma omp task if (spawn) firstprivate(gpr, pp)
+#endif
+               generateU3WeightsRec( { gpr[0], (GRT)(gpr[1] - 1), gpr[2] },
+                       shifted(pp, 1, N), taskMult(spawn, pmult), queue);
+#endif /* UNTOU3_DISABLE_TCE */
+           }
+
+       if (gpr[2]) {
+#ifndef UNTOU3_DISABLE_TCE
+           gpr[2]--;
+#else /* UNTOU3_DISABLE_TCE */
+#ifdef UNTOU3_ENABLE_OPENMP
+#pragma omp task if (spawn) firstprivate(gpr, pp)
+#endif
+               generateU3WeightsRec( { gpr[0], gpr[1], (GRT)(gpr[2] - 1) }, { pp[0], pp[1], pp[2] }, taskMult(spawn, pmult), queue); 
+#endif /* UNTOU3_DISABLE_TCE */
+       }
+
+#ifndef UNTOU3_DISABLE_TCE
+       N--;
+#endif
+   }
+#ifdef UNTOU3_DISABLE_TCE
+   else {
+#endif
+
+#ifndef UNTOU3_DISABLE_PRECALC
+
+#ifdef UNTOU3_ENABLE_DOMINANT
+   if (reachesDominant(gpr, pp, N)) 
+#endif
+   addLeaves(gpr, pp, mult);
+
+#else /* UNTOU3_DISABLE_PRECALC */
+
+   auto temp = 2 * gpr[0] + gpr[1];
+   pp[0] += temp * shell_->xyz[0][0];
+   pp[1] += temp * shell_->xyz[1][0];
+   pp[2] += temp * shell_->xyz[2][0];
+
+   if (recorded(pp)) mult[pp] += 1;
+#ifdef UNTOU3_ENABLE_STATS
+   countLeaf(0, 1, mult);
+#endif
+
+#endif /* UNTOU3_DISABLE_PRECALC */
+
+#ifdef UNTOU3_DISABLE_TCE
+   }
+#endif
+}
+
+template <typename T, typename U>
+template <typename Sink>
+void UNtoU3<T, U>::visitRec(const GelfandRow& gpr, const U3Weight& pp, Sink& sink) const
+{
+   const size_t N = gpr[0] + gpr[1] + gpr[2] - 1;
+#ifndef UNTOU3_DISABLE_PRECALC
+   if (N < shell_->leaf_level) {
+      const size_t l = leafIndex(gpr);
+      const T* w = shell_->leaf_weights.data() + 3 * shell_->leaf_ptr[l];
+      for (size_t i = shell_->leaf_ptr[l]; i < shell_->leaf_ptr[l + 1]; i++, w += 3) 
+         sink(add(pp, U3Weight{ w[0], w[1], w[2] }), shell_->leaf_counts[i]);
+      return;
+   }
+#else
+   if (N == 0) {
+      sink(shifted(pp, 2 * gpr[0] + gpr[1], 0), (U)1);
+      return;
+   }
+#endif
+   forEachLowerRow(gpr, [&](const GelfandRow& lgpr, GRT d) { visitRec(lgpr, shifted(pp, d, N), sink); });
+}
+
+template <typename T, typename U>
+template <typename F>
+void UNtoU3<T, U>::forEachLowerRow(const GelfandRow& gpr, F f)
+{
+   if (gpr[0]) {
+      f(GelfandRow{ (GRT)(gpr[0] - 1), gpr[1], gpr[2] }, 2);
+      if (gpr[2]) 
+         f(GelfandRow{ (GRT)(gpr[0] - 1), (GRT)(gpr[1] + 1), (GRT)(gpr[2] - 1) }, 1);
+   }
+   if (gpr[1]) 
+      f(GelfandRow{ gpr[0], (GRT)(gpr[1] - 1), gpr[2] }, 1);
+   if (gpr[2]) 
+      f(GelfandRow{ gpr[0], gpr[1], (GRT)(gpr[2] - 1) }, 0);
+}
+
+template <typename T, typename U>
+void UNtoU3<T, U>::mergeShifted(const std::array<const U3WeightTable*, 4>& src, const std::array<U3Weight, 4>& shift,
+      size_t k, U3WeightTable& dst)
+{
+   auto shifted = [&](size_t i, size_t j) -> U3Weight {
+      return add((*src[i])[j].first, shift[i]);
+   };
+
+   size_t total = 0;
+   for (size_t i = 0; i < k; i++) total += src[i]->size();
+   dst.clear();
+   dst.reserve(total);
+
+   std::array<size_t, 4> pos{};
+   while (true) {
+      // the smallest weight among heads of shifted tables
+      bool found = false;
+      U3Weight w{};
+      for (size_t i = 0; i < k; i++) 
+         if (pos[i] < src[i]->size()) {
+            auto v = shifted(i, pos[i]);
+            if (!found || v < w) { w = v; found = true; }
+         }
+      if (!found) break;
+
+      U mult = 0;
+      for (size_t i = 0; i < k; i++) 
+         if ((pos[i] < src[i]->size()) && (shifted(i, pos[i]) == w)) 
+            mult += (*src[i])[pos[i]++].second;
+      dst.emplace_back(w, mult);
+   }
+}
+
+template <typename T, typename U>
+void UNtoU3<T, U>::addShifted(DensePoly& dst, const DensePoly& src, T d0, T d1, U factor)
+{
+   // offsets of positions of src in dst
+   const std::ptrdiff_t dr = (std::ptrdiff_t)src.lo[0] + d0 - (std::ptrdiff_t)dst.lo[0];
+   const std::ptrdiff_t dc = (std::ptrdiff_t)src.lo[1] + d1 - (std::ptrdiff_t)dst.lo[1];
+   const std::ptrdiff_t rows = dst.rows, cols = dst.cols;
+   const std::ptrdiff_t c_begin = std::max<std::ptrdiff_t>(0, -dc), c_end = std::min<std::ptrdiff_t>(src.cols, cols - dc);
+   if (c_begin >= c_end) return;
+
+   for (std::ptrdiff_t r = std::max<std::ptrdiff_t>(0, -dr); (r < (std::ptrdiff_t)src.rows) && (r + dr < rows); r++) {
+      // (pointers are formed only to the clamped columns, which lie within both arrays)
+      U* out = dst.c.data() + (r + dr) * cols + dc + c_begin;
+      const U* in = src.c.data() + r * src.cols + c_begin;
+      for (std::ptrdiff_t c = 0; c < c_end - c_begin; c++) 
+         out[c] += factor * in[c];
+   }
+}
+
+template <typename T, typename U>
+void UNtoU3<T, U>::generateU3WeightsGF(uint16_t n2, uint16_t n1, uint16_t n0)
+{
+   const size_t N = shell_->xyz[0].size();
+   assert((size_t)(n2 + n1 + n0) == N);
+   const size_t K = (size_t)n2 + n1 + (n2 ? 1 : 0);
+
+   // labels of weights of e_k are bounded by sums of k lowest and k highest quanta
+   std::array<std::vector<uint32_t>, 2> q;
+   for (int l = 0; l < 2; l++) {
+      q[l] = shell_->xyz[l];
+      std::sort(q[l].begin(), q[l].end());
+   }
+   std::vector<DensePoly> e(K + 1);
+   std::array<T, 2> lo{ { 0, 0 } }, hi{ { 0, 0 } };
+   for (size_t k = 0; k <= K; k++) {
+      // (e_k of more than N variables is zero)
+      if (k > N) {
+         e[k] = DensePoly{ U3Weight{ 0, 0, 0 }, 0, 0, {} };
+         continue;
+      }
+      if (k > 0) 
+         for (int l = 0; l < 2; l++) {
+            lo[l] += q[l][k - 1];
+            hi[l] += q[l][N - k];
+         }
+      e[k].lo = { lo[0], lo[1], (T)(k * n_ - lo[0] - lo[1]) };
+      e[k].rows = hi[0] - lo[0] + 1;
+      e[k].cols = hi[1] - lo[1] + 1;
+      e[k].c.assign(e[k].rows * e[k].cols, 0);
+   }
+   e[0].c[0] = 1;
+
+   // e_k of the first i + 1 HO states, higher polynomials first, so that e_(k-1) is still the one of i states
+   for (size_t i = 0; i < N; i++) 
+      for (size_t k = std::min(i + 1, K); k > 0; k--) 
+         addShifted(e[k], e[k - 1], shell_->xyz[0][i], shell_->xyz[1][i], 1);
+
+   // the resulting polynomial in the layout of addToDense
+   U3Weight flo, fhi;
+   getWeightBounds(n2, n1, n0, flo, fhi);
+   DensePoly f{ flo, (size_t)(fhi[0] - flo[0] + 1), (size_t)(fhi[1] - flo[1] + 1), {} };
+   f.c.assign(f.rows * f.cols, 0);
+
+   // accumulates sign * a * b into f, the smaller polynomial is iterated over 
+   auto multiply = [&](const DensePoly& a, const DensePoly& b, U sign) {
+      const DensePoly& outer = (a.c.size() <= b.c.size()) ? a : b;
+      const DensePoly& inner = (a.c.size() <= b.c.size()) ? b : a;
+      for (size_t r = 0; r < outer.rows; r++) 
+         for (size_t c = 0; c < outer.cols; c++) 
+            if (const U factor = outer.c[r * outer.cols + c]) 
+               addShifted(f, inner, (T)(outer.lo[0] + r), (T)(outer.lo[1] + c), sign * factor);
+   };
+   multiply(e[n2 + n1], e[n2], 1);
+   if (n2) 
+      multiply(e[n2 + n1 + 1], e[n2 - 1], (U)0 - (U)1);
+
+   resetFromDense(f.c, n2, n1, n0);
+}
+
+template <typename T, typename U>
+void UNtoU3<T, U>::generateU3WeightsMemo(const std::vector<GelfandRow>& gprs, const std::vector<U3MultMap*>& mults)
+{
+   assert(gprs.size() == mults.size());
+   if (gprs.empty()) return;
+
+   const size_t Ntop = gprs[0][0] + gprs[0][1] + gprs[0][2] - 1;
+   // the number of twos and zeros never increases in lower rows, rows of a single level are thus indexed by them
+   GRT max2 = 0, max0 = 0;
+   for (const auto& gpr : gprs) {
+      assert((size_t)(gpr[0] + gpr[1] + gpr[2] - 1) == Ntop);
+      max2 = std::max(max2, gpr[0]);
+      max0 = std::max(max0, gpr[2]);
+   }
+   const size_t stride = max0 + 1;
+   const size_t nrows = (max2 + 1) * stride;
+   auto index = [stride](const GelfandRow& r) { return r[0] * stride + r[2]; };
+
+   // rows reachable from the input rows at each level 
+   std::vector<std::vector<GelfandRow>> rows(Ntop + 1);
+   std::vector<char> reached(nrows);
+   for (const auto& gpr : gprs) 
+      if (!reached[index(gpr)]) { reached[index(gpr)] = 1; rows[Ntop].push_back(gpr); }
+   for (size_t N = Ntop; N > 0; N--) {
+      std::fill(reached.begin(), reached.end(), 0);
+      for (const auto& r : rows[N])
+         forEachLowerRow(r, [&](const GelfandRow& lr, GRT) {
+            auto i = index(lr);
+            if (!reached[i]) { reached[i] = 1; rows[N - 1].push_back(lr); }
+         });
+   }
+
+   // tables of rows of the current and the lower level
+   std::vector<U3WeightTable> tables(nrows), lower(nrows);
+
+   for (const auto& r : rows[0]) {
+      T d = 2 * r[0] + r[1];
+      tables[index(r)].emplace_back(shifted({ 0, 0, 0 }, d, 0), 1);
+   }
+
+   for (size_t N = 1; N <= Ntop; N++) {
+      if (cancelled()) return;
+      std::swap(tables, lower);
+      const auto& level = rows[N];
+
+#ifdef UNTOU3_ENABLE_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+      for (long i = 0; i < (long)level.size(); i++) {
+         std::array<const U3WeightTable*, 4> src;
+         std::array<U3Weight, 4> shift;
+         size_t k = 0;
+         forEachLowerRow(level[i], [&](const GelfandRow& lr, GRT d) {
+            src[k] = &lower[index(lr)];
+            shift[k++] = shifted({ 0, 0, 0 }, d, N);
+         });
+         mergeShifted(src, shift, k, tables[index(level[i])]);
+      }
+
+      // tables of lower rows are not needed anymore
+      for (const auto& r : rows[N - 1]) U3WeightTable{}.swap(lower[index(r)]);
+   }
+
+   // tables of input rows are stored in parallel (batches of small irreps)
+#ifdef UNTOU3_ENABLE_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+   for (long i = 0; i < (long)gprs.size(); i++) 
+      for (const auto& e : tables[index(gprs[i])]) 
+         if (recorded(e.first)) (*mults[i])[e.first] += e.second;
+}
+
+#ifndef UNTOU3_DISABLE_PRECALC
+
+template <typename T, typename U>
+void UNtoU3<T, U>::init_leaves(Shell& shell, size_t depth)
+{
+   // rows of levels lower than leaf_level have at most leaf_level labels
+   shell.leaf_level = std::min(depth, shell.xyz[0].size());
+   const size_t L = shell.leaf_level;
+   auto quanta = [&shell](T d, size_t N) { return U3Weight{ (T)(d * shell.xyz[0][N]), (T)(d * shell.xyz[1][N]), (T)(d * shell.xyz[2][N]) }; };
+
+   // sorted tables of contributions of leaf rows, generated from the bottom level as by the MEMOIZED engine
+   std::vector<U3WeightTable> tables((L + 1) * (L + 1) * (L + 1));
+   for (size_t N = 0; N < L; N++)
+      for (size_t a = 0; a <= N + 1; a++)
+         for (size_t c = 0; a + c <= N + 1; c++) {
+            GelfandRow gpr{ (GRT)a, (GRT)(N + 1 - a - c), (GRT)c };
+            auto& table = tables[leafIndex(shell, gpr)];
+            if (N == 0) {
+               T d = 2 * gpr[0] + gpr[1];
+               table.emplace_back(quanta(d, 0), 1);
+               continue;
+            }
+            std::array<const U3WeightTable*, 4> src;
+            std::array<U3Weight, 4> shift;
+            size_t k = 0;
+            forEachLowerRow(gpr, [&](const GelfandRow& lgpr, GRT d) {
+               src[k] = &tables[leafIndex(shell, lgpr)];
+               shift[k++] = quanta(d, N);
+            });
+            mergeShifted(src, shift, k, table);
+         }
+
+   shell.leaf_ptr.resize(tables.size() + 1);
+   for (size_t i = 0; i < tables.size(); i++) {
+      shell.leaf_ptr[i] = shell.leaf_counts.size();
+      for (const auto& e : tables[i]) {
+         shell.leaf_weights.insert(shell.leaf_weights.end(), e.first.begin(), e.first.end());
+         shell.leaf_counts.push_back(e.second);
+      }
+   }
+   shell.leaf_ptr.back() = shell.leaf_counts.size();
+}
+
+template <typename T, typename U>
+void UNtoU3<T, U>::addLeaves(const GelfandRow& gpr, const U3Weight& pp, U3MultMap& mult) const
+{
+   const size_t l = leafIndex(gpr), begin = shell_->leaf_ptr[l], end = shell_->leaf_ptr[l + 1];
+#ifdef UNTOU3_ENABLE_STATS
+   uint64_t count = 0;
+   for (size_t i = begin; i < end; i++) count += shell_->leaf_counts[i];
+#endif
+
+#ifdef UNTOU3_ENABLE_DENSE
+   // positions of shifted weights are obtained by a single addition
+   U* data = mult.data();
+   const std::ptrdiff_t base = mult.offset(pp);
+#ifndef UNTOU3_ENABLE_DOMINANT
+   for (size_t i = begin; i < end; i++) 
+      data[base + leaf_offsets_[i]] += shell_->leaf_counts[i];
+#else
+   const T* w = shell_->leaf_weights.data() + 3 * begin;
+   for (size_t i = begin; i < end; i++, w += 3) 
+      if (recorded(add(pp, U3Weight{ w[0], w[1], w[2] }))) 
+         data[base + leaf_offsets_[i]] += shell_->leaf_counts[i];
+#endif
+#else
+   const T* w = shell_->leaf_weights.data() + 3 * begin;
+   for (size_t i = begin; i < end; i++, w += 3) {
+      const U3Weight v = add(pp, U3Weight{ w[0], w[1], w[2] });
+      if (recorded(v)) mult[v] += shell_->leaf_counts[i];
+   }
+#endif
+
+#ifdef UNTOU3_ENABLE_STATS
+   countLeaf(gpr[0] + gpr[1] + gpr[2] - 1, count, mult);
+#endif
+}
+
+#endif /* UNTOU3_DISABLE_PRECALC */
+
+#if !defined(UNTOU3_DISABLE_PRECALC) && defined(UNTOU3_ENABLE_DENSE)
+template <typename T, typename U>
+void UNtoU3<T, U>::init_leaf_offsets()
+{
+   leaf_offsets_.resize(shell_->leaf_counts.size());
+   for (size_t i = 0; i < shell_->leaf_counts.size(); i++) 
+      leaf_offsets_[i] = (std::ptrdiff_t)shell_->leaf_weights[3 * i] * (std::ptrdiff_t)mult_.stride() + (std::ptrdiff_t)shell_->leaf_weights[3 * i + 1];
+}
+#endif
+
+// Generator of U(3) weights specialized for a HO level n known at compile time.
+// HO quanta vectors are constant expressions and each level of the recursion is a separate function,
+// so the compiler can inline the recursion and fold contributions of levels into immediate operands.
+// Generation is serial and uses the RECURSIVE algorithm, the result is accessed as for UNtoU3.
+//
+// Example:
+//    UNtoU3Fixed<2> gen;             // generateXYZ is not used
+//    gen.generateU3Weights(1, 4, 1);
+//    for (const auto& pair : gen.getIrreps()) ...
+template <int n, typename T = uint32_t, typename U = uint32_t>
+class UNtoU3Fixed : public UNtoU3<T, U> 
+{
+      using Base = UNtoU3<T, U>;
+
+   public:
+      using typename Base::U3Weight;
+      using typename Base::U3MultMap;
+      using typename Base::GelfandRow;
+      using typename Base::GRT;
+
+      // number of levels (the dimension N of U(N))
+      static constexpr size_t levels = (n + 1) * (n + 2) / 2;
+
+      // HO quanta of a level N along a given axis (the same as generated by generateXYZ)
+      static constexpr T quanta(int axis, size_t N) 
+      {
+         return (axis == Base::NZ) ? n - shell(N) : ((axis == Base::NX) ? shell(N) - offset(N) : offset(N));
+      }
+
+      UNtoU3Fixed() 
+      {
+         Base::generateXYZ(n);
+#ifndef UNTOU3_DISABLE_PRECALC
+         Base::setPrecalcDepth(leaf_level);
+#endif
+      }
+
+      // Generates U(3) weights and their multiplicities for an input U(N) irrep [f] of the HO level n, 
+      // which is specified by the number of twos n2, ones n1, and zeros n0, n2+n1+n0 must be equal to levels.
+      void generateU3Weights(uint16_t n2, uint16_t n1, uint16_t n0)
+      {
+         assert(n2 + n1 + n0 == levels);
+#ifdef UNTOU3_ENABLE_OVERFLOW_CHECK
+         Base::checkBounds(n2, n1, n0);
+#endif
+         Base::clearIndex();
+         Base::resetMult(this->mult_, n2, n1, n0);
+         this->merge_time_ = 0.0;
+#if !defined(UNTOU3_DISABLE_PRECALC) && defined(UNTOU3_ENABLE_DENSE)
+         Base::init_leaf_offsets();
+#endif
+#ifdef UNTOU3_ENABLE_STATS
+         Base::resetStats(1);
+         {
+            typename Base::StatsScope bound(Base::bindStats(0, this->mult_));
+            generateRec<levels - 1>({ n2, n1, n0 }, { 0, 0, 0 }, this->mult_, IsLeaf<levels - 1>{});
+         }
+         Base::collectStats();
+#else
+         generateRec<levels - 1>({ n2, n1, n0 }, { 0, 0, 0 }, this->mult_, IsLeaf<levels - 1>{});
+#endif
+      }
+
+   private:
+      // the HO level is fixed, as well as the depth of precalculated rows
+      using Base::generateXYZ;
+      using Base::setPrecalcDepth;
+#ifdef UNTOU3_ENABLE_THREADS
+      // generation is serial and synchronous
+      using Base::generateU3WeightsAsync;
+#endif
+
+#ifndef UNTOU3_DISABLE_PRECALC
+      static constexpr size_t leaf_level = (UNTOU3_PRECALC_DEPTH < levels) ? UNTOU3_PRECALC_DEPTH : levels;
+#else
+      static constexpr size_t leaf_level = 1;
+#endif
+
+      // index of the shell k, k*(k+1)/2 <= N < (k+1)*(k+2)/2, and the position of N within the shell
+      static constexpr size_t shell(size_t N, size_t k = 0) { return (N < (k + 1) * (k + 2) / 2) ? k : shell(N, k + 1); }
+      static constexpr size_t offset(size_t N) { return N - shell(N) * (shell(N) + 1) / 2; }
+
+      template <size_t N>
+      using IsLeaf = std::integral_constant<bool, (N < leaf_level)>;
+
+      // rows of level N with lower rows
+      template <size_t N>
+      void generateRec(const GelfandRow& gpr, const U3Weight& pp, U3MultMap& mult, std::false_type)
+      {
+         constexpr T z = quanta(Base::NZ, N), x = quanta(Base::NX, N), y = quanta(Base::NY, N);
+#ifdef UNTOU3_ENABLE_STATS
+         Base::countRow(gpr, false, false);
+#endif
+         if (gpr[0]) {
+            generateRec<N - 1>({ (GRT)(gpr[0] - 1), gpr[1], gpr[2] }, Base::add(pp, { 2 * z, 2 * x, 2 * y }), 
+                  mult, IsLeaf<N - 1>{});
+            if (gpr[2]) 
+               generateRec<N - 1>({ (GRT)(gpr[0] - 1), (GRT)(gpr[1] + 1), (GRT)(gpr[2] - 1) }, Base::add(pp, { z, x, y }), 
+                     mult, IsLeaf<N - 1>{});
+         }
+         if (gpr[1]) 
+            generateRec<N - 1>({ gpr[0], (GRT)(gpr[1] - 1), gpr[2] }, Base::add(pp, { z, x, y }), mult, IsLeaf<N - 1>{});
+         if (gpr[2]) 
+            generateRec<N - 1>({ gpr[0], gpr[1], (GRT)(gpr[2] - 1) }, pp, mult, IsLeaf<N - 1>{});
+      }
+
+      // leaf rows
+      template <size_t N>
+      void generateRec(const GelfandRow& gpr, const U3Weight& pp, U3MultMap& mult, std::true_type)
+      {
+#ifndef UNTOU3_DISABLE_PRECALC
+         this->addLeaves(gpr, pp, mult);
+#else
+         const T d = 2 * gpr[0] + gpr[1];
+         const U3Weight w = Base::shifted(pp, d, 0);
+         if (Base::recorded(w)) mult[w] += 1;
+#ifdef UNTOU3_ENABLE_STATS
+         Base::countLeaf(0, 1, mult);
+#endif
+#endif
+      }
+};
+
+template <int n, typename T, typename U>
+constexpr size_t UNtoU3Fixed<n, T, U>::levels;
+
+template <int n, typename T, typename U>
+constexpr size_t UNtoU3Fixed<n, T, U>::leaf_level;
+
+template <typename T, typename U, int n>
+struct untou3_fixed_dispatch 
+{
+   template <typename F>
+   static void generate(int m, uint16_t n2, uint16_t n1, uint16_t n0, F& f)
+   {
+      if (m != n) {
+         untou3_fixed_dispatch<T, U, n + 1>::generate(m, n2, n1, n0, f);
+         return;
+      }
+      UNtoU3Fixed<n, T, U> gen;
+      gen.generateU3Weights(n2, n1, n0);
+      f(static_cast<const UNtoU3<T, U>&>(gen));
+   }
+};
+
+template <typename T, typename U>
+struct untou3_fixed_dispatch<T, U, UNTOU3_FIXED_MAX_N + 1>
+{
+   template <typename F>
+   static void generate(int m, uint16_t n2, uint16_t n1, uint16_t n0, F& f)
+   {
+      UNtoU3<T, U> gen;
+      gen.generateXYZ(m);
+      gen.generateU3Weights(n2, n1, n0);
+      f(static_cast<const UNtoU3<T, U>&>(gen));
+   }
+};
+
+// Generates U(3) weights of an input U(N) irrep [f] of a HO level n specified at runtime, where [f] is specified 
+// by the number of twos n2, ones n1, and zeros n0, and calls f(gen) with a constant reference to the generator.
+// For n <= UNTOU3_FIXED_MAX_N, UNtoU3Fixed<n, T, U> is used, otherwise UNtoU3<T, U>.
+//
+// Example:
+//    untou3_generate_fixed(n, n2, n1, n0, [](const UNtoU3<>& gen) { for (const auto& pair : gen.getIrreps()) ... });
+template <typename T = uint32_t, typename U = uint32_t, typename F>
+void untou3_generate_fixed(int n, uint16_t n2, uint16_t n1, uint16_t n0, F f)
+{
+   untou3_fixed_dispatch<T, U, 0>::generate(n, n2, n1, n0, f);
+}
 
-      // type for storing labels of U(3) weights
-      using U3Weight = std::array<T, 3>;
+// A generator of U(3) weights and their multiplicities in input U(N) irreps with labels 0, 1, ..., L, e.g., 
+// of spin-isospin coupled (L = 4) or bosonic irreps (UNtoU3 is limited to labels {2,1,0}).
+// A Gelfand pattern row is represented by its numbers of labels {n_L, ..., n_1, n_0}. Its lower rows contain all labels
+// of the row except one copy of each distinct label, and one label x, w <= x <= v, for each pair of neighboring distinct 
+// labels v > w of the row. For L = 2, the same tables as by UNtoU3 are generated (UNtoU3 is faster, since its lower rows
+// are hard-coded).
+// Resulting tables are accessed by multMap, getLevelDimensionality, and getIrreps of UNtoU3. Generation uses precalculated
+// leaf rows, tail call elimination, and OpenMP tasks (see setTaskCutoff, only DEPTH and TASKS_PER_THREAD policies are 
+// distinguished) in the same way as the RECURSIVE engine of UNtoU3.
+//
+// Example:
+//    UNtoU3Labels<4> gen;
+//    gen.generateXYZ(1);                       // n=1, N=3
+//    gen.generateU3Weights({ 1, 0, 1, 0, 1 }); // [f] = [4,2,0]
+//    for (const auto& pair : gen.getIrreps()) ...
+template <int L, typename T = uint32_t, typename U = uint32_t>
+class UNtoU3Labels : public UNtoU3<T, U> 
+{
+      static_assert(L >= 1, "UNtoU3Labels: the maximum label needs to be positive");
+      using Base = UNtoU3<T, U>;
 
-      // type of the data structure used for storing U(3) weights and their multiplicities
-#ifndef UNTOU3_DISABLE_UNORDERED
-      using U3MultMap = std::unordered_map<U3Weight, U, array_3_hasher<T>>;
-#else 
-      using U3MultMap = std::map<U3Weight, U>;
-#endif /* U3MultMap */
+   public:
+      using typename Base::U3Weight;
+      using typename Base::U3MultMap;
 
-      // type of the representation of a single Gelfand pattern row, which contain its number of twos, ones, and zeros
-      using GelfandRow = std::array<uint16_t, 3>;
-      // type of a Galfand pattern labels
-      using GRT = GelfandRow::value_type;
+      // type of the representation of a single Gelfand pattern row, which contains its numbers of labels L, L-1, ..., 0
+      using GelfandRow = std::array<uint16_t, L + 1>;
 
-      // definition of the order of axis for weight vectors
-      enum { NZ, NX, NY };
+      // Generates HO quanta vectors for given nth HO level (see UNtoU3::generateXYZ) and precalculated leaf rows.
+      void generateXYZ(int n)
+      {
+         Base::generateXYZ(n);
+#ifndef UNTOU3_DISABLE_PRECALC
+         init_leaves();
+#endif
+      }
 
-      // Generates HO quanta vectors for given nth HO level.
-      // Need to be used befor generateU3Weights member function is called.
-      void generateXYZ(int n);
+      // Sets the number of lowest Gelfand pattern rows whose contributions are precalculated (see UNtoU3::setPrecalcDepth).
+      // The depth is limited such that tables of leaf rows are indexed by at most 2^16 rows.
+      void setPrecalcDepth(size_t depth)
+      {
+         Base::setPrecalcDepth(depth);
+#ifndef UNTOU3_DISABLE_PRECALC
+         if (this->shell_) 
+            init_leaves();
+#endif
+      }
 
-      // Generates U(3) weights and their multiplicities for an input U(N) irrep [f].
-      // [f] is specified by the number of twos n2, ones n1, and zeros n0.
-      // N=n2+n1+n0 must be equal to (n+1)*(n+2)/2, where n was used as an argument of generateXYZ.
-      void generateU3Weights(uint16_t n2, uint16_t n1, uint16_t n0);
+      // Generates U(3) weights and their multiplicities for an input U(N) irrep [f] specified by its numbers of labels f,
+      // their sum N needs to be equal to (n+1)*(n+2)/2, where n was used as an argument of generateXYZ.
+      void generateU3Weights(const GelfandRow& f);
 
-      // Provides an access to the table of U(3) weights and their multiplicities generated by generateU3Weights.
-      // Returns a constant reference to the computer representation of this table of type U3MultMap.
-      const U3MultMap& multMap() const { return mult_; }
+      // Calculates the lowest and highest values of individual labels of U(3) weights in an input U(N) irrep [f].
+      void getWeightBounds(const GelfandRow& f, U3Weight& lo, U3Weight& hi) const;
 
-      // Get level dimensionality for a given U(3) weight passed as an argument.
-      U getLevelDimensionality(const U3Weight&) const;
+      // Upper bounds of labels of U(3) weights and of their multiplicities in an input U(N) irrep [f] of the HO level n
+      // (see UNtoU3::maxLabel and UNtoU3::maxMultiplicity), dim[f] is evaluated by the Weyl dimension formula.
+      static uint64_t maxLabel(int n, const GelfandRow& f) { return (uint64_t)n * labelSum(f); }
+      static long double maxMultiplicity(const GelfandRow& f);
 
    private:
-      // HO quanta vectors generated by generateXYZ
-      std::array<std::vector<uint32_t>, 3> xyz_;
-      // table of resulting U(3) irreps and their multiplicities
-      U3MultMap mult_;
-
-#ifndef UNTOU3_DISABLE_PRECALC
-      // arrays used to store precalculated contributions of low-level Gelfand patterns into resulting U(3) weights
-      std::array<std::array<std::array<uint8_t, 4>, 4>, 4> cnt_;
-      std::array<std::array<std::array<uint16_t*, 4>, 4>, 4> ptr_;
-      std::array<uint16_t, 3 * 45> conts_;
+      // generation of multiple irreps, static partitioning, and other parallel backends are not supported
+      using Base::generateU3WeightsBatch;
+      using Base::setStaticPartitioning;
+      using Base::estimateSize;
+      using Base::reserve;
+      // (dim[f] of irreps with more than two columns is not implemented, complements of [f] have other labels)
+      using Base::dimension;
+      using Base::validate;
+      using Base::complementWeights;
+      using Base::complement;
+#ifdef UNTOU3_ENABLE_THREADS
+      using Base::setExecutor;
+      using Base::generateU3WeightsAsync;
+#endif
+#ifdef UNTOU3_ENABLE_OFFLOAD
+      using Base::setOffload;
+#endif
+#ifdef UNTOU3_ENABLE_MPI
+      using Base::setCommunicator;
+#endif
+#ifdef UNTOU3_ENABLE_STATS
+      // (statistics are collected only by generators of labels {2,1,0})
+      using Base::stats;
 #endif
 
-#ifdef UNTOU3_ENABLE_OPENMP
-      // thread-local tables for generated U(3) weights and their multiplicites, which are finally merged into mult_
-      static U3MultMap* mult_tl_;
-#pragma omp threadprivate(mult_tl_)
-#endif 
+      // Enumerates count() lower rows of a row together with differences d of sums of labels of the row and the lower row.
+      // Choices of labels between neighboring distinct labels of the row are incremented as digits of an odometer.
+      class LowerRows 
+      {
+         public:
+            explicit LowerRows(const GelfandRow& gpr);
+            size_t count() const { return count_; }
+            // the first lower row, which contains the lowest choices
+            void first(GelfandRow& lgpr, T& d);
+            // advances lgpr and d to the next lower row, returns false after the last one
+            bool next(GelfandRow& lgpr, T& d);
+         private:
+            GelfandRow base_;         // labels of the row except one copy of each distinct label
+            T distinct_ = 0;          // sum of distinct labels of the row
+            size_t gaps_ = 0, count_ = 1;
+            // lowest choices of labels, their numbers, and current choices relative to the lowest ones for each gap
+            std::array<uint16_t, L> low_, width_, choice_;
+      };
 
-      // Recursive function for generation of Gelfand patterns.
-      // It calls itself for all possible lower Gelfand pattern rows generated by the input Gelfand pattern row.
-      // At the end of recursion, it increments the multiplicity of resulting U(3) weight ith mult_ (or mult_tl_).
-      // gpr - representation of an input gelfand pattern row 
-      // pp - partial contribution of higher Gelfand pattern rows to the generated U(3) weights
-      void generateU3WeightsRec(GelfandRow gpr, U3Weight pp);
+      static size_t level(const GelfandRow& gpr) 
+      {
+         size_t N = 0;
+         for (auto c : gpr) N += c;
+         return N - 1;
+      }
+      static uint64_t labelSum(const GelfandRow& gpr)
+      {
+         uint64_t sum = 0;
+         for (int j = 0; j <= L; j++) sum += (uint64_t)(L - j) * gpr[j];
+         return sum;
+      }
 
-#ifndef UNTOU3_DISABLE_PRECALC
-      // initialize arrays cnt_ and ptr_
-      void init_cnt_ptr();
-      // initialize array conts_
-      void init_conts();
-#endif
-};
+      // prepares a table for generation of U(3) weights of [f]
+      void resetMult(U3MultMap& mult, const GelfandRow& f) const;
 
-#ifdef UNTOU3_ENABLE_OPENMP
-template <typename T, typename U>
-typename UNtoU3<T, U>::U3MultMap* UNtoU3<T, U>::mult_tl_;
-#endif
+      // Recursive function for generation of Gelfand patterns (see UNtoU3::generateU3WeightsRec).
+      void generateRec(GelfandRow gpr, U3Weight pp, U3MultMap& mult);
 
-template <typename T, typename U>
-UNtoU3<T, U>::UNtoU3() 
-{
 #ifdef UNTOU3_ENABLE_OPENMP
-#pragma omp parallel
-   mult_tl_ = new U3MultMap{};
-#endif 
+      // lower rows of rows at level N >= task_level_ are generated by new tasks
+      size_t task_level_ = 0;
+      // sets task_level_ for [f] generated by a given number of threads
+      void setupTasks(const GelfandRow& f, size_t threads);
+#endif
 
 #ifndef UNTOU3_DISABLE_PRECALC
-   init_cnt_ptr();
+      // rows of lower levels than leaf_level_ are leaves of the recursion, their contributions are stored
+      // in the same way as by UNtoU3, rows are indexed by their numbers of labels in the radix leaf_level_ + 1
+      size_t leaf_level_ = 0;
+      std::vector<uint32_t> leaf_ptr_;
+      std::vector<T> leaf_weights_;
+      std::vector<U> leaf_counts_;
+
+      size_t leafIndex(const GelfandRow& gpr) const 
+      {
+         size_t l = 0;
+         for (auto c : gpr) l = l * (leaf_level_ + 1) + c;
+         return l;
+      }
+
+      // generates contributions of leaf rows for the current HO level
+      void init_leaves();
+      // adds precalculated contributions of a leaf row gpr shifted by pp to mult
+      void addLeaves(const GelfandRow& gpr, const U3Weight& pp, U3MultMap& mult) const
+      {
+         const size_t l = leafIndex(gpr);
+         const T* w = leaf_weights_.data() + 3 * leaf_ptr_[l];
+         for (size_t i = leaf_ptr_[l]; i < leaf_ptr_[l + 1]; i++, w += 3) {
+            const U3Weight v = Base::add(pp, U3Weight{ w[0], w[1], w[2] });
+            if (Base::recorded(v)) mult[v] += leaf_counts_[i];
+         }
+      }
 #endif
-}
+};
 
-template <typename T, typename U>
-UNtoU3<T, U>::~UNtoU3() 
+template <int L, typename T, typename U>
+UNtoU3Labels<L, T, U>::LowerRows::LowerRows(const GelfandRow& gpr) : base_(gpr)
 {
-#ifdef UNTOU3_ENABLE_OPENMP
-#pragma omp parallel
-   delete mult_tl_;
-#endif
+   int previous = -1; // previous distinct label
+   for (int j = 0; j <= L; j++) 
+      if (gpr[j]) {
+         const int v = L - j;
+         base_[j]--;
+         distinct_ += v;
+         if (previous >= 0) {
+            low_[gaps_] = v;
+            width_[gaps_] = previous - v + 1;
+            count_ *= width_[gaps_++];
+         }
+         previous = v;
+      }
 }
 
-template <typename T, typename U>
-void UNtoU3<T, U>::generateXYZ(int n)
+template <int L, typename T, typename U>
+void UNtoU3Labels<L, T, U>::LowerRows::first(GelfandRow& lgpr, T& d)
 {
-   for (auto & v : xyz_) v.clear();
+   lgpr = base_;
+   d = distinct_;
+   for (size_t g = 0; g < gaps_; g++) {
+      choice_[g] = 0;
+      lgpr[L - low_[g]]++;
+      d -= low_[g];
+   }
+}
 
-   for (int k = 0; k <= n; k++) {
-      uint32_t nz = n - k;
-      for (int nx = k; nx >= 0; nx--) {
-         xyz_[NX].push_back(nx);
-         xyz_[NY].push_back(n - nz - nx);
-         xyz_[NZ].push_back(nz);
+template <int L, typename T, typename U>
+bool UNtoU3Labels<L, T, U>::LowerRows::next(GelfandRow& lgpr, T& d)
+{
+   for (size_t g = 0; g < gaps_; g++) {
+      const int x = low_[g] + choice_[g];
+      lgpr[L - x]--;
+      if (choice_[g] + 1 < width_[g]) {
+         // label x is replaced by x + 1
+         lgpr[L - x - 1]++;
+         d--;
+         choice_[g]++;
+         return true;
       }
+      // label x is reset to the lowest choice and the next gap is incremented
+      lgpr[L - low_[g]]++;
+      d += choice_[g];
+      choice_[g] = 0;
    }
-
-#ifndef UNTOU3_DISABLE_PRECALC
-   init_conts();
-#endif
+   return false;
 }
 
-template <typename T, typename U>
-U UNtoU3<T, U>::getLevelDimensionality(const U3Weight& labels) const
+template <int L, typename T, typename U>
+void UNtoU3Labels<L, T, U>::getWeightBounds(const GelfandRow& f, U3Weight& lo, U3Weight& hi) const
 {
-   T f1 = labels[0], f2 = labels[1], f3 = labels[2];
-   if ((f1 < f2) || (f2 < f3)) return 0;
-
-   auto u3_mult = mult_.find({f1, f2, f3});
-   assert(u3_mult != mult_.end());
-   auto mult = u3_mult->second;
-
-   u3_mult = mult_.find({f1 + 1, f2 + 1, f3 - 2});
-   mult += (u3_mult == mult_.end()) ? 0 : u3_mult->second;
-
-   u3_mult = mult_.find({f1 + 2, f2 - 1, f3 - 1});
-   mult += (u3_mult == mult_.end()) ? 0 : u3_mult->second;
-
-   u3_mult = mult_.find({f1 + 2, f2, f3 - 2});
-   mult -= (u3_mult == mult_.end()) ? 0 : u3_mult->second;
+   for (int k = 0; k < 3; k++) {
+      // labels are maximal (minimal) when the highest labels of [f] are assigned to the highest (lowest) quanta
+      const auto& q = this->shell_->sorted[k];
+      T l = 0, h = 0;
+      size_t i = 0;
+      for (int j = 0; j <= L; j++) 
+         for (uint16_t c = 0; c < f[j]; c++, i++) {
+            l += (T)(L - j) * q[i];
+            h += (T)(L - j) * q[q.size() - 1 - i];
+         }
+      lo[k] = l; hi[k] = h;
+   }
+}
 
-   u3_mult = mult_.find({f1 + 1, f2 - 1, f3});
-   mult -= (u3_mult == mult_.end()) ? 0 : u3_mult->second;
+template <int L, typename T, typename U>
+long double UNtoU3Labels<L, T, U>::maxMultiplicity(const GelfandRow& f)
+{
+   std::vector<int> m;
+   for (int j = 0; j <= L; j++) 
+      m.insert(m.end(), f[j], L - j);
 
-   u3_mult = mult_.find({f1, f2 + 1, f3 - 1});
-   mult -= (u3_mult == mult_.end()) ? 0 : u3_mult->second;
+   // dim[f] = prod_{i < j} (m_i - m_j + j - i) / (j - i) 
+   long double dim = 1.0L;
+   for (size_t i = 0; i < m.size(); i++) 
+      for (size_t j = i + 1; j < m.size(); j++) 
+         dim *= (long double)(m[i] - m[j] + (int)(j - i)) / (long double)(j - i);
+   return dim * (1.0L + 1e-12L);
+}
 
-   return mult;
+template <int L, typename T, typename U>
+void UNtoU3Labels<L, T, U>::resetMult(U3MultMap& mult, const GelfandRow& f) const
+{
+   U3Weight lo, hi;
+   getWeightBounds(f, lo, hi);
+#ifdef UNTOU3_ENABLE_DENSE
+   mult.reshape(lo, hi, this->n_ * labelSum(f));
+#else
+   const long double box = (long double)(hi[0] - lo[0] + 1) * (hi[1] - lo[1] + 1);
+   mult.clear();
+   Base::reserveTable(mult, (size_t)std::min(box, maxMultiplicity(f)), 0);
+#endif
 }
 
-template <typename T, typename U>
-void UNtoU3<T, U>::generateU3Weights(uint16_t n2, uint16_t n1, uint16_t n0)
+template <int L, typename T, typename U>
+void UNtoU3Labels<L, T, U>::generateU3Weights(const GelfandRow& f)
 {
-   mult_.clear(); // ???
-// for (auto & e : mult_) e.second = 0; // ???
-   
+   assert(level(f) + 1 == this->shell_->xyz[0].size());
+#ifdef UNTOU3_ENABLE_OVERFLOW_CHECK
+   if (maxLabel(this->n_, f) > (T)~(T)0)
+      throw std::overflow_error("UNtoU3Labels: labels of U(3) weights might overflow T");
+   if (maxMultiplicity(f) > (long double)(U)~(U)0)
+      throw std::overflow_error("UNtoU3Labels: multiplicities of U(3) weights might overflow U");
+#endif
+   Base::clearIndex();
+   resetMult(this->mult_, f);
+   this->merge_time_ = 0.0;
+
 #ifdef UNTOU3_ENABLE_OPENMP
 
+   setupTasks(f, omp_get_max_threads());
+   double merge_start = 0.0;
 #pragma omp parallel
    {
-      mult_tl_->clear(); // ???
-   // for (auto & e : *mult_tl_) e.second = 0; // ???
 #pragma omp single
-      generateU3WeightsRec({n2, n1, n0}, {0, 0, 0});
-#pragma omp critical
-      for (const auto temp : *mult_tl_)
-         mult_[temp.first] += temp.second;
+      {
+         const size_t nt = omp_get_num_threads();
+         if (this->mult_tl_.size() < nt) 
+            this->mult_tl_.resize(nt);
+#ifdef UNTOU3_ENABLE_NUMA
+         this->numa_tl_.resize(this->mult_tl_.size(), -1);
+#endif
+      }
+
+#ifdef UNTOU3_ENABLE_NUMA
+      Base::placeNuma();
+#endif
+      auto& mult_tl = this->mult_tl_[omp_get_thread_num()];
+      if (!mult_tl) 
+         mult_tl.reset(new U3MultMap{});
+      resetMult(*mult_tl, f);
+#pragma omp barrier
+#pragma omp single
+      generateRec(f, { 0, 0, 0 }, *mult_tl);
+
+#pragma omp master
+      merge_start = omp_get_wtime();
+      Base::mergeThreadLocal();
    }
 
+   std::swap(this->mult_, *this->mult_tl_[0]);
+   this->merge_time_ = omp_get_wtime() - merge_start;
+
 #else  /* UNTOU3_ENABLE_OPENMP */
 
-   generateU3WeightsRec({n2, n1, n0}, {0, 0, 0});
+   generateRec(f, { 0, 0, 0 }, this->mult_);
 
 #endif /* UNTOU3_ENABLE_OPENMP */
 }
 
-template <typename T, typename U>
-void UNtoU3<T, U>::generateU3WeightsRec(GelfandRow gpr, U3Weight pp) 
+#ifdef UNTOU3_ENABLE_OPENMP
+template <int L, typename T, typename U>
+void UNtoU3Labels<L, T, U>::setupTasks(const GelfandRow& f, size_t threads)
 {
-   size_t N = gpr[0] + gpr[1] + gpr[2] - 1;
+   const size_t Ntop = level(f);
+   size_t depth = 0;
+   if (this->task_cutoff_ == Base::TaskCutoff::DEPTH) 
+      depth = (size_t)std::max(this->task_cutoff_value_, 0.0);
+   else {
+      // the lowest depth with enough subtrees (numbers of paths to distinct rows are counted level by level)
+      const double tasks = ((this->task_cutoff_ == Base::TaskCutoff::TASKS_PER_THREAD) ? std::max(this->task_cutoff_value_, 1.0) : 64.0) 
+         * (double)threads;
+      std::map<GelfandRow, double> rows{ { f, 1.0 } }, next;
+      double subtrees = 1.0;
+      GelfandRow lgpr;
+      T d;
+      while ((subtrees < tasks) && (depth < Ntop)) {
+         next.clear();
+         subtrees = 0.0;
+         for (const auto& row : rows) {
+            LowerRows lower(row.first);
+            lower.first(lgpr, d);
+            do {
+               next[lgpr] += row.second;
+               subtrees += row.second;
+            } while (lower.next(lgpr, d));
+         }
+         rows.swap(next);
+         depth++;
+      }
+   }
+   task_level_ = (depth > Ntop) ? 0 : Ntop + 1 - depth;
+}
+#endif /* UNTOU3_ENABLE_OPENMP */
+
+template <int L, typename T, typename U>
+void UNtoU3Labels<L, T, U>::generateRec(GelfandRow gpr, U3Weight pp, U3MultMap& mult)
+{
+   size_t N = level(gpr);
+   U3MultMap* pmult = &mult;
 
 #ifndef UNTOU3_DISABLE_TCE
    while
 #else
    if
 #endif
-   (N > 
 #ifndef UNTOU3_DISABLE_PRECALC
-   2
+   (N >= leaf_level_)
 #else 
-   0
+   (N > 0)
 #endif 
-   ) {
-       if (gpr[0]) {
-           if (gpr[1] || gpr[2]) {
-#ifdef UNTOU3_ENABLE_OPENMP
-#pragma omp task if (N > 8) firstprivate(gpr, pp)
-#endif
-               generateU3WeightsRec( { (GRT)(gpr[0] - 1), gpr[1], gpr[2] }, 
-                       { pp[0] + 2 * xyz_[0][N], pp[1] + 2 * xyz_[1][N], pp[2] + 2 * xyz_[2][N] });
-               if (gpr[2]) 
-#ifdef UNTOU3_ENABLE_OPENMP
-#pragma omp task if (N > 8) firstprivate(gpr, pp)
-#endif
-                   generateU3WeightsRec( { (GRT)(gpr[0] - 1), (GRT)(gpr[1] + 1), (GRT)(gpr[2] - 1) },
-                           { pp[0] + xyz_[0][N], pp[1] + xyz_[1][N], pp[2] + xyz_[2][N] });
-           }
-           else {
-#ifndef UNTOU3_DISABLE_TCE
-               gpr[0]--;
-               pp[0] += 2 * xyz_[0][N]; pp[1] += 2 * xyz_[1][N]; pp[2] += 2 * xyz_[2][N];
-#else /* UNTOU3_DISABLE_TCE */
+   {
 #ifdef UNTOU3_ENABLE_OPENMP
-#pragma omp task if (N > 8) firstprivate(gpr, pp)
+      const bool spawn = (N >= task_level_);
+#else
+      const bool spawn = false;
 #endif
-               generateU3WeightsRec( { (GRT)(gpr[0] - 1), gpr[1], gpr[2] }, 
-                       { pp[0] + 2 * xyz_[0][N], pp[1] + 2 * xyz_[1][N], pp[2] + 2 * xyz_[2][N] });
-#endif /* UNTOU3_DISABLE_TCE */
-           }
-       }
+      LowerRows lower(gpr);
+      GelfandRow lgpr;
+      T d;
+      lower.first(lgpr, d);
 
-       if (gpr[1]) 
-           if (gpr[2])
-#ifdef UNTOU3_ENABLE_OPENMP
-#pragma omp task if (N > 8) firstprivate(gpr, pp)
-#endif
-               generateU3WeightsRec( { gpr[0], (GRT)(gpr[1] - 1), gpr[2] },
-                       { pp[0] + xyz_[0][N], pp[1] + xyz_[1][N], pp[2] + xyz_[2][N] });
-           else {
+      // the last lower row is generated by the next iteration 
 #ifndef UNTOU3_DISABLE_TCE
-              gpr[1]--; 
-              pp[0] += xyz_[0][N]; pp[1] += xyz_[1][N]; pp[2] += xyz_[2][N];
-#else /* UNTOU3_DISABLE_TCE */
-#ifdef UNTOU3_ENABLE_OPENMP
-#pragma omp task if (N > 8) firstprivate(gpr, pp)
+      const size_t calls = lower.count() - 1;
+#else
+      const size_t calls = lower.count();
 #endif
-               generateU3WeightsRec( { gpr[0], (GRT)(gpr[1] - 1), gpr[2] },
-                       { pp[0] + xyz_[0][N], pp[1] + xyz_[1][N], pp[2] + xyz_[2][N] });
-#endif /* UNTOU3_DISABLE_TCE */
-           }
-
-       if (gpr[2]) {
-#ifndef UNTOU3_DISABLE_TCE
-           gpr[2]--;
-#else /* UNTOU3_DISABLE_TCE */
+      for (size_t i = 0; i < calls; i++, lower.next(lgpr, d)) {
 #ifdef UNTOU3_ENABLE_OPENMP
-#pragma omp task if (N > 8) firstprivate(gpr, pp)
+#pragma omp task if (spawn) firstprivate(lgpr, d, pp)
 #endif
-               generateU3WeightsRec( { gpr[0], gpr[1], (GRT)(gpr[2] - 1) }, { pp[0], pp[1], pp[2] }); 
-#endif /* UNTOU3_DISABLE_TCE */
-       }
+         generateRec(lgpr, Base::shifted(pp, d, N), Base::taskMult(spawn, pmult));
+      }
 
 #ifndef UNTOU3_DISABLE_TCE
-       N--;
+      gpr = lgpr;
+      pp = Base::shifted(pp, d, N);
+      N--;
+#else
+      (void)spawn;
 #endif
    }
 #ifdef UNTOU3_DISABLE_TCE
@@ -312,279 +3790,315 @@ void UNtoU3<T, U>::generateU3WeightsRec(GelfandRow gpr, U3Weight pp)
 #endif
 
 #ifndef UNTOU3_DISABLE_PRECALC
-
-   auto c = cnt_[gpr[0]][gpr[1]][gpr[2]];
-   if (c > 0) {
-      auto p = ptr_[gpr[0]][gpr[1]][gpr[2]];
-      for (int i = 0; i < c; i++) {
-         U3Weight pp_;
-         pp_[0] = pp[0] + *p++;
-         pp_[1] = pp[1] + *p++;
-         pp_[2] = pp[2] + *p++;
-#ifdef UNTOU3_ENABLE_OPENMP
-         (*mult_tl_)[pp_] += 1;
+   addLeaves(gpr, pp, mult);
 #else
-         mult_[pp_] += 1;
+   // a single label of the row of level 0
+   T v = 0;
+   for (int j = 0; j <= L; j++) 
+      if (gpr[j]) v = L - j;
+   const U3Weight w = Base::shifted(pp, v, 0);
+   if (Base::recorded(w)) mult[w] += 1;
 #endif
-      }
+
+#ifdef UNTOU3_DISABLE_TCE
    }
-   else  {
-#ifdef UNTOU3_ENABLE_OPENMP
-      (*mult_tl_)[pp] += 1;
-#else
-      mult_[pp] += 1;
 #endif
-   }
+}
 
-#else /* UNTOU3_DISABLE_PRECALC */
+#ifndef UNTOU3_DISABLE_PRECALC
+template <int L, typename T, typename U>
+void UNtoU3Labels<L, T, U>::init_leaves()
+{
+   // rows of levels lower than leaf_level_ have at most leaf_level_ labels, each of their numbers is thus lower than
+   // leaf_level_ + 1; the depth is decreased until the number of indexes (leaf_level_ + 1)^(L + 1) is at most 2^16
+   leaf_level_ = std::min(this->precalc_depth_, this->shell_->xyz[0].size());
+   auto indexes = [&]() { 
+      size_t size = 1;
+      for (int j = 0; (j <= L) && (size <= (1 << 16)); j++) size *= leaf_level_ + 1;
+      return size; 
+   };
+   while ((leaf_level_ > 1) && (indexes() > (1 << 16))) 
+      leaf_level_--;
 
-   auto temp = 2 * gpr[0] + gpr[1];
-   pp[0] += temp * xyz_[0][0];
-   pp[1] += temp * xyz_[1][0];
-   pp[2] += temp * xyz_[2][0];
+   // tables of rows are generated level by level from the bottom as maps, which are small
+   std::vector<std::map<U3Weight, U>> tables(indexes());
+   std::vector<GelfandRow> rows{ GelfandRow{} }, next;
+   for (size_t N = 0; N < leaf_level_; N++) {
+      // rows of level N are obtained by adding a label to rows of level N - 1
+      next.clear();
+      for (const auto& row : rows) 
+         for (int j = 0; j <= L; j++) {
+            GelfandRow gpr = row;
+            gpr[j]++;
+            if (std::find(next.begin(), next.end(), gpr) == next.end()) 
+               next.push_back(gpr);
+         }
+      rows.swap(next);
 
-#ifdef UNTOU3_ENABLE_OPENMP
-   (*mult_tl_)[pp] += 1;
-#else
-   mult_[pp] += 1;
-#endif
+      for (const auto& gpr : rows) {
+         auto& table = tables[leafIndex(gpr)];
+         if (N == 0) {
+            table[Base::shifted({ 0, 0, 0 }, (T)labelSum(gpr), 0)] = 1;
+            continue;
+         }
+         LowerRows lower(gpr);
+         GelfandRow lgpr;
+         T d;
+         lower.first(lgpr, d);
+         do {
+            const U3Weight shift = Base::shifted({ 0, 0, 0 }, d, N);
+            for (const auto& e : tables[leafIndex(lgpr)]) 
+               table[Base::add(e.first, shift)] += e.second;
+         } while (lower.next(lgpr, d));
+      }
+   }
 
+   leaf_ptr_.resize(tables.size() + 1);
+   leaf_weights_.clear();
+   leaf_counts_.clear();
+   for (size_t i = 0; i < tables.size(); i++) {
+      leaf_ptr_[i] = leaf_counts_.size();
+      for (const auto& e : tables[i]) {
+         leaf_weights_.insert(leaf_weights_.end(), e.first.begin(), e.first.end());
+         leaf_counts_.push_back(e.second);
+      }
+   }
+   leaf_ptr_.back() = leaf_counts_.size();
+}
 #endif /* UNTOU3_DISABLE_PRECALC */
 
-#ifdef UNTOU3_DISABLE_TCE
-   }
+#ifdef __SIZEOF_INT128__
+__extension__ typedef unsigned __int128 untou3_uint128;
 #endif
+
+template <typename T, typename U, typename F>
+void untou3_generate_typed(int n, uint16_t n2, uint16_t n1, uint16_t n0, F& f)
+{
+   UNtoU3<T, U> gen;
+   gen.generateXYZ(n);
+   gen.generateU3Weights(n2, n1, n0);
+   f(static_cast<const UNtoU3<T, U>&>(gen));
 }
 
-#ifndef UNTOU3_DISABLE_PRECALC
+template <typename T, typename F>
+void untou3_generate_adaptive_mult(int n, uint16_t n2, uint16_t n1, uint16_t n0, F& f)
+{
+   const long double mult = UNtoU3<T>::maxMultiplicity(n2, n1, n0);
+   if (mult <= (long double)UINT32_MAX)
+      untou3_generate_typed<T, uint32_t>(n, n2, n1, n0, f);
+   else if (mult <= (long double)UINT64_MAX)
+      untou3_generate_typed<T, uint64_t>(n, n2, n1, n0, f);
+#ifdef __SIZEOF_INT128__
+   else if (mult <= (long double)(untou3_uint128)~(untou3_uint128)0)
+      untou3_generate_typed<T, untou3_uint128>(n, n2, n1, n0, f);
+#endif
+   else
+      throw std::overflow_error("untou3_generate_adaptive: multiplicities of U(3) weights might overflow all types");
+}
 
-template <typename T, typename U>
-void UNtoU3<T, U>::init_cnt_ptr()
-{
-   for (int i = 0; i < 4; i++)
-      for (int j = 0; j < 4; j++)
-         for (int k = 0; k < 4; k++)
-            cnt_[i][j][k] = 0;
-
-   cnt_[3][0][0] = 1; cnt_[0][3][0] = 1;                     //  2
-   cnt_[2][1][0] = 3; cnt_[2][0][1] = 6; cnt_[1][2][0] = 3;  // 12
-   cnt_[0][2][1] = 3; cnt_[1][0][2] = 6; cnt_[0][1][2] = 3;  // 12
-   cnt_[1][1][1] = 8;                                        //  8
-   cnt_[2][0][0] = 1; cnt_[0][2][0] = 1;                     //  2
-   cnt_[1][1][0] = 2; cnt_[1][0][1] = 3; cnt_[0][1][1] = 2;  //  7
-   cnt_[1][0][0] = 1; cnt_[0][1][0] = 1;                     //  2
-
-   auto p = conts_.data();
-   ptr_[3][0][0] = p; p += 1 * 3; ptr_[0][3][0] = p; p += 1 * 3;                    
-   ptr_[2][1][0] = p; p += 3 * 3; ptr_[2][0][1] = p; p += 6 * 3; ptr_[1][2][0] = p; p += 3 * 3;  
-   ptr_[0][2][1] = p; p += 3 * 3; ptr_[1][0][2] = p; p += 6 * 3; ptr_[0][1][2] = p; p += 3 * 3;  
-   ptr_[1][1][1] = p; p += 8 * 3;                                      
-   ptr_[2][0][0] = p; p += 1 * 3; ptr_[0][2][0] = p; p += 1 * 3;                   
-   ptr_[1][1][0] = p; p += 2 * 3; ptr_[1][0][1] = p; p += 3 * 3; ptr_[0][1][1] = p; p += 2 * 3;  
-   ptr_[1][0][0] = p; p += 1 * 3; ptr_[0][1][0] = p;                    
+// Generates U(3) weights of an input U(N) irrep [f] of a HO level n, where [f] is specified by the number of twos n2, 
+// ones n1, and zeros n0, by UNtoU3<T, U> with the narrowest types that cannot overflow according to maxLabel and 
+// maxMultiplicity: T is uint16_t or uint32_t, U is uint32_t, uint64_t, or untou3_uint128 (if supported by the compiler).
+// Calls f(gen) with a constant reference to the generator, f thus needs to accept all these types of generators.
+// Throws std::overflow_error if no types are wide enough.
+//
+// Example:
+//    struct sum_dims { template <typename G> void operator()(const G& gen) const { ... } };
+//    untou3_generate_adaptive(n, n2, n1, n0, sum_dims{});
+template <typename F>
+void untou3_generate_adaptive(int n, uint16_t n2, uint16_t n1, uint16_t n0, F f)
+{
+   const uint64_t label = UNtoU3<>::maxLabel(n, n2, n1, n0);
+   if (label <= UINT16_MAX)
+      untou3_generate_adaptive_mult<uint16_t>(n, n2, n1, n0, f);
+   else if (label <= UINT32_MAX)
+      untou3_generate_adaptive_mult<uint32_t>(n, n2, n1, n0, f);
+   else
+      throw std::overflow_error("untou3_generate_adaptive: labels of U(3) weights might overflow all types");
 }
 
-template <typename T, typename U>
-void UNtoU3<T, U>::init_conts() 
+// A sink for generateU3Weights that converts generated weights into contributions to level dimensionalities of U(3) irreps,
+// which are passed to f(irrep, count, sign), where irrep is [f1,f2,f3] (f1 >= f2 >= f3) and sign is +1 or -1.
+// The level dimensionality of an irrep is the signed sum of its counts (see getLevelDimensionality), linear reductions
+// over U(3) irreps weighted by their level dimensionalities (e.g., the sum of their dimensions) thus do not need a table.
+//
+// Example:
+//    long sum = 0;
+//    gen.generateU3Weights(n2, n1, n0, untou3_make_irrep_sink([&](const UNtoU3<>::U3Weight& f, uint32_t count, int sign) {
+//       sum += sign * (long)count * dim(f); }));
+template <typename F>
+class untou3_irrep_sink
 {
-   auto p = conts_.data();
-   // (3,0,0)
-   *p++ = 2 * xyz_[0][2] + 2 * xyz_[0][1] + 2 * xyz_[0][0];
-   *p++ = 2 * xyz_[1][2] + 2 * xyz_[1][1] + 2 * xyz_[1][0];
-   *p++ = 2 * xyz_[2][2] + 2 * xyz_[2][1] + 2 * xyz_[2][0];
-
-   // (0,3,0)
-   *p++ = 1 * xyz_[0][2] + 1 * xyz_[0][1] + 1 * xyz_[0][0];
-   *p++ = 1 * xyz_[1][2] + 1 * xyz_[1][1] + 1 * xyz_[1][0];
-   *p++ = 1 * xyz_[2][2] + 1 * xyz_[2][1] + 1 * xyz_[2][0];
-
-   // (2,1,0)
-   *p++ = 1 * xyz_[0][2] + 2 * xyz_[0][1] + 2 * xyz_[0][0];
-   *p++ = 1 * xyz_[1][2] + 2 * xyz_[1][1] + 2 * xyz_[1][0];
-   *p++ = 1 * xyz_[2][2] + 2 * xyz_[2][1] + 2 * xyz_[2][0];
-
-   *p++ = 2 * xyz_[0][2] + 1 * xyz_[0][1] + 2 * xyz_[0][0];
-   *p++ = 2 * xyz_[1][2] + 1 * xyz_[1][1] + 2 * xyz_[1][0];
-   *p++ = 2 * xyz_[2][2] + 1 * xyz_[2][1] + 2 * xyz_[2][0];
-
-   *p++ = 2 * xyz_[0][2] + 2 * xyz_[0][1] + 1 * xyz_[0][0];
-   *p++ = 2 * xyz_[1][2] + 2 * xyz_[1][1] + 1 * xyz_[1][0];
-   *p++ = 2 * xyz_[2][2] + 2 * xyz_[2][1] + 1 * xyz_[2][0];
-
-   // (2,0,1)
-   *p++ = 0 * xyz_[0][2] + 2 * xyz_[0][1] + 2 * xyz_[0][0];
-   *p++ = 0 * xyz_[1][2] + 2 * xyz_[1][1] + 2 * xyz_[1][0];
-   *p++ = 0 * xyz_[2][2] + 2 * xyz_[2][1] + 2 * xyz_[2][0];
-
-   *p++ = 1 * xyz_[0][2] + 1 * xyz_[0][1] + 2 * xyz_[0][0];
-   *p++ = 1 * xyz_[1][2] + 1 * xyz_[1][1] + 2 * xyz_[1][0];
-   *p++ = 1 * xyz_[2][2] + 1 * xyz_[2][1] + 2 * xyz_[2][0];
-
-   *p++ = 1 * xyz_[0][2] + 2 * xyz_[0][1] + 1 * xyz_[0][0];
-   *p++ = 1 * xyz_[1][2] + 2 * xyz_[1][1] + 1 * xyz_[1][0];
-   *p++ = 1 * xyz_[2][2] + 2 * xyz_[2][1] + 1 * xyz_[2][0];
-
-   *p++ = 2 * xyz_[0][2] + 0 * xyz_[0][1] + 2 * xyz_[0][0];
-   *p++ = 2 * xyz_[1][2] + 0 * xyz_[1][1] + 2 * xyz_[1][0];
-   *p++ = 2 * xyz_[2][2] + 0 * xyz_[2][1] + 2 * xyz_[2][0];
-
-   *p++ = 2 * xyz_[0][2] + 1 * xyz_[0][1] + 1 * xyz_[0][0];
-   *p++ = 2 * xyz_[1][2] + 1 * xyz_[1][1] + 1 * xyz_[1][0];
-   *p++ = 2 * xyz_[2][2] + 1 * xyz_[2][1] + 1 * xyz_[2][0];
-
-   *p++ = 2 * xyz_[0][2] + 2 * xyz_[0][1] + 0 * xyz_[0][0];
-   *p++ = 2 * xyz_[1][2] + 2 * xyz_[1][1] + 0 * xyz_[1][0];
-   *p++ = 2 * xyz_[2][2] + 2 * xyz_[2][1] + 0 * xyz_[2][0];
-
-   // (1,2,0)
-   *p++ = 1 * xyz_[0][2] + 1 * xyz_[0][1] + 2 * xyz_[0][0];
-   *p++ = 1 * xyz_[1][2] + 1 * xyz_[1][1] + 2 * xyz_[1][0];
-   *p++ = 1 * xyz_[2][2] + 1 * xyz_[2][1] + 2 * xyz_[2][0];
-
-   *p++ = 1 * xyz_[0][2] + 2 * xyz_[0][1] + 1 * xyz_[0][0];
-   *p++ = 1 * xyz_[1][2] + 2 * xyz_[1][1] + 1 * xyz_[1][0];
-   *p++ = 1 * xyz_[2][2] + 2 * xyz_[2][1] + 1 * xyz_[2][0];
-
-   *p++ = 2 * xyz_[0][2] + 1 * xyz_[0][1] + 1 * xyz_[0][0];
-   *p++ = 2 * xyz_[1][2] + 1 * xyz_[1][1] + 1 * xyz_[1][0];
-   *p++ = 2 * xyz_[2][2] + 1 * xyz_[2][1] + 1 * xyz_[2][0];
-
-   // (0,2,1)
-   *p++ = 0 * xyz_[0][2] + 1 * xyz_[0][1] + 1 * xyz_[0][0];
-   *p++ = 0 * xyz_[1][2] + 1 * xyz_[1][1] + 1 * xyz_[1][0];
-   *p++ = 0 * xyz_[2][2] + 1 * xyz_[2][1] + 1 * xyz_[2][0];
-
-   *p++ = 1 * xyz_[0][2] + 0 * xyz_[0][1] + 1 * xyz_[0][0];
-   *p++ = 1 * xyz_[1][2] + 0 * xyz_[1][1] + 1 * xyz_[1][0];
-   *p++ = 1 * xyz_[2][2] + 0 * xyz_[2][1] + 1 * xyz_[2][0];
-
-   *p++ = 1 * xyz_[0][2] + 1 * xyz_[0][1] + 0 * xyz_[0][0];
-   *p++ = 1 * xyz_[1][2] + 1 * xyz_[1][1] + 0 * xyz_[1][0];
-   *p++ = 1 * xyz_[2][2] + 1 * xyz_[2][1] + 0 * xyz_[2][0];
-
-   // (1,0,2)
-   *p++ = 0 * xyz_[0][2] + 0 * xyz_[0][1] + 2 * xyz_[0][0];
-   *p++ = 0 * xyz_[1][2] + 0 * xyz_[1][1] + 2 * xyz_[1][0];
-   *p++ = 0 * xyz_[2][2] + 0 * xyz_[2][1] + 2 * xyz_[2][0];
-
-   *p++ = 0 * xyz_[0][2] + 1 * xyz_[0][1] + 1 * xyz_[0][0];
-   *p++ = 0 * xyz_[1][2] + 1 * xyz_[1][1] + 1 * xyz_[1][0];
-   *p++ = 0 * xyz_[2][2] + 1 * xyz_[2][1] + 1 * xyz_[2][0];
-
-   *p++ = 0 * xyz_[0][2] + 2 * xyz_[0][1] + 0 * xyz_[0][0];
-   *p++ = 0 * xyz_[1][2] + 2 * xyz_[1][1] + 0 * xyz_[1][0];
-   *p++ = 0 * xyz_[2][2] + 2 * xyz_[2][1] + 0 * xyz_[2][0];
-
-   *p++ = 1 * xyz_[0][2] + 0 * xyz_[0][1] + 1 * xyz_[0][0];
-   *p++ = 1 * xyz_[1][2] + 0 * xyz_[1][1] + 1 * xyz_[1][0];
-   *p++ = 1 * xyz_[2][2] + 0 * xyz_[2][1] + 1 * xyz_[2][0];
-
-   *p++ = 1 * xyz_[0][2] + 1 * xyz_[0][1] + 0 * xyz_[0][0];
-   *p++ = 1 * xyz_[1][2] + 1 * xyz_[1][1] + 0 * xyz_[1][0];
-   *p++ = 1 * xyz_[2][2] + 1 * xyz_[2][1] + 0 * xyz_[2][0];
-
-   *p++ = 2 * xyz_[0][2] + 0 * xyz_[0][1] + 0 * xyz_[0][0];
-   *p++ = 2 * xyz_[1][2] + 0 * xyz_[1][1] + 0 * xyz_[1][0];
-   *p++ = 2 * xyz_[2][2] + 0 * xyz_[2][1] + 0 * xyz_[2][0];
-
-   // (0,1,2)
-   *p++ = 0 * xyz_[0][2] + 0 * xyz_[0][1] + 1 * xyz_[0][0];
-   *p++ = 0 * xyz_[1][2] + 0 * xyz_[1][1] + 1 * xyz_[1][0];
-   *p++ = 0 * xyz_[2][2] + 0 * xyz_[2][1] + 1 * xyz_[2][0];
-
-   *p++ = 0 * xyz_[0][2] + 1 * xyz_[0][1] + 0 * xyz_[0][0];
-   *p++ = 0 * xyz_[1][2] + 1 * xyz_[1][1] + 0 * xyz_[1][0];
-   *p++ = 0 * xyz_[2][2] + 1 * xyz_[2][1] + 0 * xyz_[2][0];
-
-   *p++ = 1 * xyz_[0][2] + 0 * xyz_[0][1] + 0 * xyz_[0][0];
-   *p++ = 1 * xyz_[1][2] + 0 * xyz_[1][1] + 0 * xyz_[1][0];
-   *p++ = 1 * xyz_[2][2] + 0 * xyz_[2][1] + 0 * xyz_[2][0];
-
-   // (1,1,1)
-   *p++ = 0 * xyz_[0][2] + 1 * xyz_[0][1] + 2 * xyz_[0][0];
-   *p++ = 0 * xyz_[1][2] + 1 * xyz_[1][1] + 2 * xyz_[1][0];
-   *p++ = 0 * xyz_[2][2] + 1 * xyz_[2][1] + 2 * xyz_[2][0];
-
-   *p++ = 0 * xyz_[0][2] + 2 * xyz_[0][1] + 1 * xyz_[0][0];
-   *p++ = 0 * xyz_[1][2] + 2 * xyz_[1][1] + 1 * xyz_[1][0];
-   *p++ = 0 * xyz_[2][2] + 2 * xyz_[2][1] + 1 * xyz_[2][0];
-
-   *p++ = 1 * xyz_[0][2] + 0 * xyz_[0][1] + 2 * xyz_[0][0];
-   *p++ = 1 * xyz_[1][2] + 0 * xyz_[1][1] + 2 * xyz_[1][0];
-   *p++ = 1 * xyz_[2][2] + 0 * xyz_[2][1] + 2 * xyz_[2][0];
-
-   *p++ = 1 * xyz_[0][2] + 1 * xyz_[0][1] + 1 * xyz_[0][0];
-   *p++ = 1 * xyz_[1][2] + 1 * xyz_[1][1] + 1 * xyz_[1][0];
-   *p++ = 1 * xyz_[2][2] + 1 * xyz_[2][1] + 1 * xyz_[2][0];
-
-   *p++ = 1 * xyz_[0][2] + 2 * xyz_[0][1] + 0 * xyz_[0][0];
-   *p++ = 1 * xyz_[1][2] + 2 * xyz_[1][1] + 0 * xyz_[1][0];
-   *p++ = 1 * xyz_[2][2] + 2 * xyz_[2][1] + 0 * xyz_[2][0];
-
-   *p++ = 1 * xyz_[0][2] + 1 * xyz_[0][1] + 1 * xyz_[0][0];
-   *p++ = 1 * xyz_[1][2] + 1 * xyz_[1][1] + 1 * xyz_[1][0];
-   *p++ = 1 * xyz_[2][2] + 1 * xyz_[2][1] + 1 * xyz_[2][0];
-
-   *p++ = 2 * xyz_[0][2] + 0 * xyz_[0][1] + 1 * xyz_[0][0];
-   *p++ = 2 * xyz_[1][2] + 0 * xyz_[1][1] + 1 * xyz_[1][0];
-   *p++ = 2 * xyz_[2][2] + 0 * xyz_[2][1] + 1 * xyz_[2][0];
-
-   *p++ = 2 * xyz_[0][2] + 1 * xyz_[0][1] + 0 * xyz_[0][0];
-   *p++ = 2 * xyz_[1][2] + 1 * xyz_[1][1] + 0 * xyz_[1][0];
-   *p++ = 2 * xyz_[2][2] + 1 * xyz_[2][1] + 0 * xyz_[2][0];
-
-   // (2,0,0)
-   *p++ = 2 * xyz_[0][1] + 2 * xyz_[0][0];
-   *p++ = 2 * xyz_[1][1] + 2 * xyz_[1][0];
-   *p++ = 2 * xyz_[2][1] + 2 * xyz_[2][0];
-
-   // (0,2,0)
-   *p++ = 1 * xyz_[0][1] + 1 * xyz_[0][0];
-   *p++ = 1 * xyz_[1][1] + 1 * xyz_[1][0];
-   *p++ = 1 * xyz_[2][1] + 1 * xyz_[2][0];
-
-   // (1,1,0)
-   *p++ = 1 * xyz_[0][1] + 2 * xyz_[0][0];
-   *p++ = 1 * xyz_[1][1] + 2 * xyz_[1][0];
-   *p++ = 1 * xyz_[2][1] + 2 * xyz_[2][0];
-
-   *p++ = 2 * xyz_[0][1] + 1 * xyz_[0][0];
-   *p++ = 2 * xyz_[1][1] + 1 * xyz_[1][0];
-   *p++ = 2 * xyz_[2][1] + 1 * xyz_[2][0];
-
-   // (1,0,1)
-   *p++ = 0 * xyz_[0][1] + 2 * xyz_[0][0];
-   *p++ = 0 * xyz_[1][1] + 2 * xyz_[1][0];
-   *p++ = 0 * xyz_[2][1] + 2 * xyz_[2][0];
-
-   *p++ = 2 * xyz_[0][1] + 0 * xyz_[0][0];
-   *p++ = 2 * xyz_[1][1] + 0 * xyz_[1][0];
-   *p++ = 2 * xyz_[2][1] + 0 * xyz_[2][0];
-
-   *p++ = 1 * xyz_[0][1] + 1 * xyz_[0][0];
-   *p++ = 1 * xyz_[1][1] + 1 * xyz_[1][0];
-   *p++ = 1 * xyz_[2][1] + 1 * xyz_[2][0];
-
-   // (0,1,1)
-   *p++ = 0 * xyz_[0][1] + 1 * xyz_[0][0];
-   *p++ = 0 * xyz_[1][1] + 1 * xyz_[1][0];
-   *p++ = 0 * xyz_[2][1] + 1 * xyz_[2][0];
-
-   *p++ = 1 * xyz_[0][1] + 0 * xyz_[0][0];
-   *p++ = 1 * xyz_[1][1] + 0 * xyz_[1][0];
-   *p++ = 1 * xyz_[2][1] + 0 * xyz_[2][0];
-
-   // (1,0,0)
-   *p++ = 2 * xyz_[0][0];
-   *p++ = 2 * xyz_[1][0];
-   *p++ = 2 * xyz_[2][0];
+   public:
+      explicit untou3_irrep_sink(F f) : f_(f) { }
+
+      template <typename W, typename C>
+      void operator()(const W& w, C count) 
+      {
+         // a weight w contributes to irreps w - delta, where w - delta are weights of the terms of getLevelDimensionality
+         contribute(w, 0, 0, 0, count, +1);
+         contribute(w, 1, 1, -2, count, +1);
+         contribute(w, 2, -1, -1, count, +1);
+         contribute(w, 2, 0, -2, count, -1);
+         contribute(w, 1, -1, 0, count, -1);
+         contribute(w, 0, 1, -1, count, -1);
+      }
 
-   // (0,1,0)
-   *p++ = 1 * xyz_[0][0];
-   *p++ = 1 * xyz_[1][0];
-   *p++ = 1 * xyz_[2][0];
+      const F& function() const { return f_; }
+
+   private:
+      F f_;
+
+      template <typename W, typename C>
+      void contribute(const W& w, long d1, long d2, long d3, C count, int sign)
+      {
+         const long f1 = (long)w[0] - d1, f2 = (long)w[1] - d2, f3 = (long)w[2] - d3;
+         using L = typename W::value_type;
+         if ((f1 >= f2) && (f2 >= f3) && (f3 >= 0)) 
+            f_(W{ (L)f1, (L)f2, (L)f3 }, count, sign);
+      }
+};
+
+template <typename F>
+untou3_irrep_sink<F> untou3_make_irrep_sink(F f)
+{
+   return untou3_irrep_sink<F>(f);
 }
 
-#endif /* UNTOU3_DISABLE_PRECALC */
+// A sink for generateU3Weights that passes weights to all of given sinks (referenced, not copied), such that multiple 
+// reductions are evaluated by a single generation, e.g.:
+//    gen.generateU3Weights(n2, n1, n0, untou3_compose(irreps, histogram));
+template <typename... Sinks>
+class untou3_composed_sink;
+
+template <>
+class untou3_composed_sink<>
+{
+   public:
+      template <typename W, typename C>
+      void operator()(const W&, C) { }
+};
+
+template <typename S, typename... Sinks>
+class untou3_composed_sink<S, Sinks...> : private untou3_composed_sink<Sinks...>
+{
+   public:
+      explicit untou3_composed_sink(S& sink, Sinks&... sinks) : untou3_composed_sink<Sinks...>(sinks...), sink_(sink) { }
+
+      template <typename W, typename C>
+      void operator()(const W& w, C count)
+      {
+         sink_(w, count);
+         untou3_composed_sink<Sinks...>::operator()(w, count);
+      }
+
+   private:
+      S& sink_;
+};
+
+template <typename... Sinks>
+untou3_composed_sink<Sinks...> untou3_compose(Sinks&... sinks)
+{
+   return untou3_composed_sink<Sinks...>(sinks...);
+}
+
+#ifdef UNTOU3_ENABLE_CACHE
+// A class that provides tables of U(3) weights and their multiplicities in the same way as UNtoU3, but stores them into files
+// of a cache directory (see untou3_cache_header), which are mapped into memory by array_3_mapped_table. A table is generated
+// only if its file does not exist or does not match (e.g., it was written with different types), later jobs thus start warm
+// and a cache directory may be shared by jobs running on multiple nodes.
+//
+// Example:
+//    UNtoU3Cache<> cache("/path/to/cache");
+//    cache.generateXYZ(n);
+//    cache.generateU3Weights(n2, n1, n0); // maps the file of [f], which is generated and written first if needed
+//    for (const auto& pair : cache.getIrreps()) ...
+template <typename T = uint32_t, typename U = uint32_t>
+class UNtoU3Cache
+{
+   public:
+      using U3Weight = typename UNtoU3<T, U>::U3Weight;
+      using U3MultMap = array_3_mapped_table<T, U>;
+      using U3WeightTable = typename UNtoU3<T, U>::U3WeightTable;
+
+      explicit UNtoU3Cache(const std::string& directory) : directory_(directory) { }
+
+      // Sets the HO level n of input U(N) irreps. HO quanta vectors are generated only once a table needs to be generated.
+      void generateXYZ(int n) { n_ = n; }
+
+      // Maps the table of U(3) weights of an input U(N) irrep [f] specified by the number of twos n2, ones n1, and zeros n0
+      // from the cache directory. If it is not cached, it is derived from the cached table of its complement [2^n0 1^n1 0^n2]
+      // (see UNtoU3::complementWeights), or generated by generator(), and written into the directory first.
+      // Returns true if a cached table (of [f] or its complement) was used.
+      bool generateU3Weights(uint16_t n2, uint16_t n1, uint16_t n0);
+
+      // Provides an access to the table mapped by generateU3Weights.
+      const U3MultMap& multMap() const { return mult_; }
+
+      // Get level dimensionality for a given U(3) weight passed as an argument (see UNtoU3::getLevelDimensionality).
+      U getLevelDimensionality(const U3Weight& labels) const { return UNtoU3<T, U>::getLevelDimensionality(mult_, labels); }
+
+      // Returns U(3) irreps with nonzero level dimensionalities contained in the mapped table (see UNtoU3::getIrreps).
+      U3WeightTable getIrreps() const;
+
+      // path of the file of [f] in the cache directory
+      std::string path(uint16_t n2, uint16_t n1, uint16_t n0) const
+      {
+         return directory_ + "/untou3_" + std::to_string(n_) + "_" + std::to_string(n2) + "_" + std::to_string(n1) + "_" 
+            + std::to_string(n0) + "_" + std::to_string(8 * sizeof(T)) + "_" + std::to_string(8 * sizeof(U)) + ".bin";
+      }
+
+      // generator of tables that are not cached, which can be configured (precalculation depth, executor, ...)
+      UNtoU3<T, U>& generator() { return gen_; }
+
+   private:
+      std::string directory_;
+      int n_ = -1;     // HO level set by generateXYZ
+      int xyz_n_ = -1; // HO level of HO quanta vectors of gen_
+      UNtoU3<T, U> gen_;
+      U3MultMap mult_;
+};
+
+template <typename T, typename U>
+bool UNtoU3Cache<T, U>::generateU3Weights(uint16_t n2, uint16_t n1, uint16_t n0)
+{
+   assert(n_ >= 0);
+   const std::string file = path(n2, n1, n0);
+   if (mult_.map(file, n_, n2, n1, n0)) return true;
+
+   if (xyz_n_ != n_) {
+      gen_.generateXYZ(n_);
+      xyz_n_ = n_;
+   }
+   bool cached = false;
+   if (n2 != n0) {
+      U3MultMap complement;
+      if (complement.map(path(n0, n1, n2), n_, n0, n1, n2)) {
+         typename UNtoU3<T, U>::U3MultMap table;
+         gen_.complementWeights(complement, table, n0, n1, n2);
+         U3MultMap::write(file, n_, n2, n1, n0, table);
+         cached = true;
+      }
+   }
+   if (!cached) {
+      gen_.generateU3Weights(n2, n1, n0);
+      U3MultMap::write(file, n_, n2, n1, n0, gen_.multMap());
+   }
+   if (!mult_.map(file, n_, n2, n1, n0)) 
+      throw std::runtime_error("UNtoU3Cache: cannot map file " + file);
+   return cached;
+}
+
+template <typename T, typename U>
+typename UNtoU3Cache<T, U>::U3WeightTable UNtoU3Cache<T, U>::getIrreps() const
+{
+   // entries are sorted, so are the irreps
+   U3WeightTable irreps;
+   for (const auto& pair : mult_) 
+      if (auto D_l = getLevelDimensionality(pair.first)) 
+         irreps.emplace_back(pair.first, D_l);
+   return irreps;
+}
+#endif /* UNTOU3_ENABLE_CACHE */
 
 #endif /* UNTOU3_H */
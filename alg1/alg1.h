@@ -0,0 +1,133 @@
+// alg1.h - original U(N)->U(3) reduction implemented by LSU3shell
+// 
+// License: BSD 2-Clause (https://opensource.org/licenses/BSD-2-Clause)
+//
+// Copyright (c) 2019, Daniel Langr
+// All rights reserved.
+//
+// Functions of the original algorithm shared by test_alg1.cpp and benchmark drivers:
+// GenerateU3SPS generates HO quanta vectors of the HO level n, GenerateU3Labels generates U(3) weights and their 
+// multiplicities in an input U(N) irrep specified by its labels, and GetMultiplicity evaluates level dimensionalities.
+
+#ifndef ALG1_H
+#define ALG1_H
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <map>
+#include <numeric>
+#include <vector>
+
+namespace U3 {
+   using LABELS = std::array<uint32_t, 3>;
+   using SPS = std::array<std::vector<uint32_t>, 3>;
+   enum { NZ, NX, NY };
+};
+
+namespace UN {
+   using LABELS = std::vector<uint8_t>;
+   using BASIS_STATE_WEIGHT_VECTOR = std::vector<uint8_t>;
+   using U3MULT_LIST = std::map<U3::LABELS, uint32_t>;
+}
+
+enum { MULT, LM, MU, S2 };
+
+inline void Weight2U3Label(const UN::BASIS_STATE_WEIGHT_VECTOR& vWeights, const U3::SPS& ShellSPS,
+                           U3::LABELS& vU3Labels) {
+   vU3Labels[U3::NZ] =
+       std::inner_product(ShellSPS[U3::NZ].begin(), ShellSPS[U3::NZ].end(), vWeights.begin(), 0);
+   vU3Labels[U3::NX] =
+       std::inner_product(ShellSPS[U3::NX].begin(), ShellSPS[U3::NX].end(), vWeights.begin(), 0);
+   vU3Labels[U3::NY] =
+       std::inner_product(ShellSPS[U3::NY].begin(), ShellSPS[U3::NY].end(), vWeights.begin(), 0);
+}
+
+inline void GenerateU3Labels(const UN::LABELS& vGelfandParentRow, uint32_t uSumGelfandParentRow,
+                             const U3::SPS& ShellSPS, UN::BASIS_STATE_WEIGHT_VECTOR& vWeights,
+                             UN::U3MULT_LIST& mU3LabelsOccurance) {
+   size_t N = vGelfandParentRow.size() - 1;
+
+   std::vector<UN::LABELS> vvAllowedLabels;
+   UN::LABELS vGelfandRow(N);
+   std::vector<uint32_t> vElemsPerChange(N, 1);  // Fill with 1 cause vElemsPerChange[0] = 1;
+   std::vector<size_t> vNLabels(N);
+
+   // evaluate all allowed Gelfand patterns based on a parent Gelfand row
+   // (vGelfandParentRow) and store them in vvAllowedLabels
+   // iNAllowedCombinations is equal to the number of allowed Gelfand patterns
+   uint32_t iNAllowedCombinations = 1;
+   for (size_t i = 0; i < N; i++) {
+      uint32_t uLabelMin = std::min(vGelfandParentRow[i + 1], vGelfandParentRow[i]);
+      uint32_t uLabelMax = std::max(vGelfandParentRow[i + 1], vGelfandParentRow[i]);
+      UN::LABELS vLabels(uLabelMax - uLabelMin + 1);
+      std::iota(vLabels.begin(), vLabels.end(), uLabelMin);
+      vNLabels[i] = vLabels.size();
+      iNAllowedCombinations *= vNLabels[i];
+      vvAllowedLabels.push_back(std::move(vLabels));
+   }
+
+   for (size_t i = 1; i < N; i++) {
+      vElemsPerChange[i] = vElemsPerChange[i - 1] *
+                           vNLabels[i - 1];  // if i == 0 => vElemsPerChange[0]=1 since constructor
+   }
+
+   for (uint32_t index = 0; index < iNAllowedCombinations; index++) {
+      for (size_t i = 0; i < N; i++) {
+         size_t iElement = (index / vElemsPerChange[i]) % vNLabels[i];
+         vGelfandRow[i] = vvAllowedLabels[i][iElement];
+      }
+      uint32_t uSumGelfandRow = std::accumulate(vGelfandRow.begin(), vGelfandRow.end(), 0);
+      vWeights[N] = uSumGelfandParentRow - uSumGelfandRow;
+      if (N > 1) {  // this condition is due to n = 0 case when N = 0 and hence one wants to keep
+                    // vWeights[0] = uSumGelfandRow;
+         GenerateU3Labels(vGelfandRow, uSumGelfandRow, ShellSPS, vWeights, mU3LabelsOccurance);
+      } else {
+         if (N == 1) {
+            vWeights[0] = uSumGelfandRow;
+         }
+         U3::LABELS vU3Labels = {0, 0, 0};
+         Weight2U3Label(vWeights, ShellSPS, vU3Labels);
+         mU3LabelsOccurance[vU3Labels] += 1;
+      }
+   }
+}
+
+inline uint32_t GetMultiplicity(const U3::LABELS u3_labels, const UN::U3MULT_LIST& u3_mult_map) {
+   auto u3_mult = u3_mult_map.find(u3_labels);
+   assert(u3_mult != u3_mult_map.end());
+
+   uint32_t f1 = u3_labels[0], f2 = u3_labels[1], f3 = u3_labels[2];
+   uint32_t mult = u3_mult->second;
+
+   u3_mult = u3_mult_map.find({f1 + 1, f2 + 1, f3 - 2});
+   mult += (u3_mult == u3_mult_map.end()) ? 0 : u3_mult->second;
+
+   u3_mult = u3_mult_map.find({f1 + 2, f2 - 1, f3 - 1});
+   mult += (u3_mult == u3_mult_map.end()) ? 0 : u3_mult->second;
+
+   u3_mult = u3_mult_map.find({f1 + 2, f2, f3 - 2});
+   mult -= (u3_mult == u3_mult_map.end()) ? 0 : u3_mult->second;
+
+   u3_mult = u3_mult_map.find({f1 + 1, f2 - 1, f3});
+   mult -= (u3_mult == u3_mult_map.end()) ? 0 : u3_mult->second;
+
+   u3_mult = u3_mult_map.find({f1, f2 + 1, f3 - 1});
+   mult -= (u3_mult == u3_mult_map.end()) ? 0 : u3_mult->second;
+
+   return mult;
+}
+
+inline void GenerateU3SPS(int n, U3::SPS& ShellSPS) {
+   for (int k = 0; k <= n; k++) {
+      uint32_t nz = n - k;
+      for (int nx = k; nx >= 0; nx--) {
+         ShellSPS[U3::NX].push_back(nx);
+         ShellSPS[U3::NY].push_back(n - nz - nx);
+         ShellSPS[U3::NZ].push_back(nz);
+      }
+   }
+}
+
+#endif /* ALG1_H */
@@ -0,0 +1,123 @@
+// bench_hash.cpp - a benchmark of hash tables used for storing U(3) weights.
+//
+// License: BSD 2-Clause (https://opensource.org/licenses/BSD-2-Clause)
+//
+// Copyright (c) 2019, Daniel Langr
+// All rights reserved.
+//
+// Program reads the HO level n and the number of twos, ones, and zeros of an input U(N) irrep from the standard input
+// (in the same way as test_input). For instance, the workload of test_6114 is specified by: 5 6 1 14.
+//
+// U(3) weights of the input irrep are generated first. A sequence of insertions is then formed such that
+// each weight is inserted as many times as is its multiplicity (at most 16 times), in a pseudo-random order.
+// This sequence is replayed into the following hash tables:
+//    legacy - std::unordered_map with the original hasher key[0] + (key[1] << 8) + (key[2] << 16)
+//    packed - std::unordered_map with array_3_hasher
+//    flat   - array_3_flat_map with array_3_hasher
+// Then, the table is iterated over and each weight is looked up together with its 5 neighbors needed by
+// getLevelDimensionality (which is how test drivers evaluate level dimensionalities).
+//
+// For each table, one line of comma-separated values is printed to the standard output:
+// table name, number of weights, load factor, mean and maximum probe length, insertions per second, lookups per second.
+// Probe length is the position of a weight within its bucket list (unordered_map) or the number of inspected slots (flat).
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#define UNTOU3_ENABLE_FLAT
+#include "UNtoU3.h"
+
+using Gen = UNtoU3<>;
+using Weight = Gen::U3Weight;
+
+// the original hasher of UNtoU3, whose bit fields overlap for labels higher than 255
+struct legacy_hasher
+{
+   std::size_t operator()(const Weight& key) const
+   {
+      return key[0] + (key[1] << 8) + (key[2] << 16);
+   }
+};
+
+template <typename H>
+size_t probe_length(const std::unordered_map<Weight, uint32_t, H>& table, const Weight& key) {
+   auto b = table.bucket(key);
+   size_t length = 1;
+   for (auto it = table.begin(b); it != table.end(b) && it->first != key; ++it)
+      length++;
+   return length;
+}
+
+size_t probe_length(const array_3_flat_map<uint32_t, uint32_t>& table, const Weight& key) {
+   return table.probe_length(key);
+}
+
+template <typename Table>
+void bench(const char* name, const std::vector<Weight>& inserts, const std::vector<Weight>& weights) {
+   Table table;
+
+   auto start = std::chrono::steady_clock::now();
+   for (const auto& w : inserts) table[w] += 1;
+   auto end = std::chrono::steady_clock::now();
+   double insert_time = std::chrono::duration<double>(end - start).count();
+
+   size_t sum = 0, max = 0;
+   for (const auto& w : weights) {
+      auto l = probe_length(table, w);
+      sum += l;
+      max = std::max(max, l);
+   }
+
+   uint32_t checksum = 0;
+   start = std::chrono::steady_clock::now();
+   for (const auto& pair : table) {
+      const auto& w = pair.first;
+      const Weight lookups[6] = { { w[0], w[1], w[2] }, { w[0] + 1, w[1] + 1, w[2] - 2 }, { w[0] + 2, w[1] - 1, w[2] - 1 },
+         { w[0] + 2, w[1], w[2] - 2 }, { w[0] + 1, w[1] - 1, w[2] }, { w[0], w[1] + 1, w[2] - 1 } };
+      for (const auto& l : lookups) {
+         auto it = table.find(l);
+         checksum += (it == table.end()) ? 0 : it->second;
+      }
+   }
+   end = std::chrono::steady_clock::now();
+   double lookup_time = std::chrono::duration<double>(end - start).count();
+
+   std::cout << name << "," << table.size() << "," << table.load_factor() << ","
+      << (double)sum / weights.size() << "," << max << ","
+      << inserts.size() / insert_time << "," << 6 * weights.size() / lookup_time << std::endl;
+
+   // prevents the lookups from being optimized out
+   volatile uint32_t sink = checksum;
+   (void)sink;
+}
+
+int main() {
+   // HO level
+   unsigned long n;
+   // specification of intput U(N) irrep
+   unsigned short n2, n1, n0;
+   std::cin >> n >> n2 >> n1 >> n0;
+
+   if ((unsigned long)(n2 + n1 + n0) != (n + 1) * (n + 2) / 2)
+      throw std::invalid_argument("Arguments mismatch!");
+
+   Gen gen;
+   gen.generateXYZ(n);
+   gen.generateU3Weights(n2, n1, n0, Gen::Engine::MEMOIZED);
+
+   std::vector<Weight> weights, inserts;
+   for (const auto& pair : gen.multMap()) {
+      weights.push_back(pair.first);
+      inserts.insert(inserts.end(), std::min<uint32_t>(pair.second, 16), pair.first);
+   }
+   std::shuffle(inserts.begin(), inserts.end(), std::mt19937{ 2019 });
+
+   std::cout << "table,weights,load_factor,mean_probe,max_probe,inserts_per_s,lookups_per_s" << std::endl;
+   bench<std::unordered_map<Weight, uint32_t, legacy_hasher>>("legacy", inserts, weights);
+   bench<std::unordered_map<Weight, uint32_t, array_3_hasher<uint32_t>>>("packed", inserts, weights);
+   bench<array_3_flat_map<uint32_t, uint32_t>>("flat", inserts, weights);
+}
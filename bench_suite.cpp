@@ -0,0 +1,142 @@
+// bench_suite.cpp - a benchmark of UNtoU3 configurations and of the original algorithm alg1.
+//
+// License: BSD 2-Clause (https://opensource.org/licenses/BSD-2-Clause)
+//
+// Copyright (c) 2019, Daniel Langr
+// All rights reserved.
+//
+// Program runs the U(N) to U(3) reduction for a fixed grid of input irreps specified by the HO level n and the number 
+// of twos, ones, and zeros (as in test_input), or for a single irrep given by 4 command line arguments, e.g.:
+//    ./bench_suite.base 5 6 1 14
+// With UNTOU3_ENABLE_OPENMP, each irrep is reduced by 1, 2, 4, ... threads up to omp_get_max_threads().
+// The program is built by make bench for every combination of UNTOU3_DISABLE_TCE, UNTOU3_DISABLE_UNORDERED, 
+// UNTOU3_DISABLE_PRECALC, and UNTOU3_ENABLE_OPENMP (configuration name BENCH_CONFIG), and with BENCH_ALG1 for alg1.
+//
+// Each reduction runs in a child process, so that its peak resident set size is measured separately.
+// One line of comma-separated values is printed to the standard output for each reduction (after a header line):
+// configuration, n, n2, n1, n0, number of threads, wall time of generation of U(3) weights [s], number of Gelfand patterns
+// (sum of multiplicities of U(3) weights, which is equal to dim[f]), patterns per second, peak RSS [kB], and table size
+// (number of U(3) weights with nonzero multiplicities).
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifdef BENCH_ALG1
+#include "alg1/alg1.h"
+#else
+#include "UNtoU3.h"
+#endif
+
+#ifndef BENCH_CONFIG
+#define BENCH_CONFIG "custom"
+#endif
+
+struct bench_case { unsigned short n, n2, n1, n0; };
+
+// the grid of input irreps, from fast to more demanding ones
+const bench_case grid[] = { { 3, 3, 4, 3 }, { 4, 5, 6, 4 }, { 5, 3, 8, 10 }, { 5, 6, 1, 14 } };
+
+// results of a reduction passed from the child process
+struct bench_result { double time; unsigned long long patterns, size; };
+
+bench_result reduce(const bench_case& c) {
+   bench_result result{ 0.0, 0, 0 };
+#ifdef BENCH_ALG1
+   U3::SPS ShellSPS;
+   GenerateU3SPS(c.n, ShellSPS);
+   UN::LABELS UNLabels(c.n2, 2);
+   UNLabels.insert(UNLabels.end(), c.n1, 1);
+   UNLabels.insert(UNLabels.end(), c.n0, 0);
+   const uint32_t sumUNLabels = std::accumulate(UNLabels.begin(), UNLabels.end(), 0);
+   UN::U3MULT_LIST mult;
+   UN::BASIS_STATE_WEIGHT_VECTOR Weight(UNLabels.size());
+
+   auto start = std::chrono::steady_clock::now();
+   GenerateU3Labels(UNLabels, sumUNLabels, ShellSPS, Weight, mult);
+   result.time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+#else
+   UNtoU3<> gen;
+   gen.generateXYZ(c.n);
+
+   auto start = std::chrono::steady_clock::now();
+   gen.generateU3Weights(c.n2, c.n1, c.n0);
+   result.time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+   const auto& mult = gen.multMap();
+#endif
+   for (const auto& pair : mult) 
+      if (pair.second) {
+         result.patterns += pair.second;
+         result.size++;
+      }
+   return result;
+}
+
+// runs the reduction in a child process and prints its results
+void bench(const bench_case& c, int threads) {
+   int fd[2];
+   if (pipe(fd) != 0)
+      throw std::runtime_error("bench_suite: cannot create pipe");
+   std::cout.flush();
+
+   const pid_t pid = fork();
+   if (pid < 0)
+      throw std::runtime_error("bench_suite: cannot fork");
+   if (pid == 0) {
+      close(fd[0]);
+#ifdef UNTOU3_ENABLE_OPENMP
+      omp_set_num_threads(threads);
+#endif
+      const bench_result result = reduce(c);
+      const bool written = write(fd[1], &result, sizeof(result)) == (ssize_t)sizeof(result);
+      _exit(written ? 0 : 1);
+   }
+
+   close(fd[1]);
+   bench_result result;
+   const bool received = read(fd[0], &result, sizeof(result)) == (ssize_t)sizeof(result);
+   close(fd[0]);
+   int status;
+   struct rusage usage;
+   if ((wait4(pid, &status, 0, &usage) != pid) || !WIFEXITED(status) || (WEXITSTATUS(status) != 0) || !received)
+      throw std::runtime_error("bench_suite: reduction failed");
+
+   // ru_maxrss is in kilobytes on Linux
+   std::cout << BENCH_CONFIG << "," << c.n << "," << c.n2 << "," << c.n1 << "," << c.n0 << "," << threads << "," 
+      << result.time << "," << result.patterns << "," << result.patterns / result.time << "," << usage.ru_maxrss << "," 
+      << result.size << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+   std::vector<bench_case> cases(std::begin(grid), std::end(grid));
+   if (argc == 5) 
+      cases.assign(1, bench_case{ (unsigned short)std::atoi(argv[1]), (unsigned short)std::atoi(argv[2]), 
+         (unsigned short)std::atoi(argv[3]), (unsigned short)std::atoi(argv[4]) });
+   else if (argc != 1)
+      throw std::invalid_argument("Usage: bench_suite [n n2 n1 n0]");
+   for (const auto& c : cases)
+      if (c.n2 + c.n1 + c.n0 != (c.n + 1) * (c.n + 2) / 2)
+         throw std::invalid_argument("Arguments mismatch!");
+
+   // the parent process does not run parallel regions, so that child processes start without OpenMP threads
+   std::vector<int> threads{ 1 };
+#ifdef UNTOU3_ENABLE_OPENMP
+   const int max_threads = omp_get_max_threads();
+   for (int t = 2; t < max_threads; t *= 2) threads.push_back(t);
+   if (max_threads > 1) threads.push_back(max_threads);
+#endif
+
+   std::cout << "config,n,n2,n1,n0,threads,wall_s,patterns,patterns_per_s,peak_rss_kb,table_size" << std::endl;
+   for (const auto& c : cases)
+      for (int t : threads)
+         bench(c, t);
+}
@@ -18,7 +18,9 @@
 
 // #define UNTOU3_DISABLE_TCO
 // #define UNTOU3_DISABLE_UNORDERED
+// #define UNTOU3_ENABLE_DENSE
 // #define UNTOU3_DISABLE_PRECALC
+// #define UNTOU3_ENABLE_THREADS
 #define UNTOU3_ENABLE_OPENMP
 #include "UNtoU3.h"
 
@@ -28,20 +30,20 @@ unsigned long dim(const UNtoU3<>::U3Weight & irrep) {
 
 int main() {
    UNtoU3<> gen;
+#ifdef UNTOU3_ENABLE_THREADS
+   // parallel generation by std::threads instead of OpenMP
+   untou3_thread_executor executor;
+   gen.setExecutor(&executor);
+#endif
    // n=5 - a given HO level, N = (n+1)*(n+2)/2 = 21 
    gen.generateXYZ(5); 
    // generation of U(3) irreps in the input U(21) irrep [f]
    gen.generateU3Weights(6, 1, 14);
    // calculated sum
    unsigned long sum = 0;
-   // iteration over generated U(3) weights
-   for (const auto & pair : gen.multMap()) {
-      // get U(3) weight lables
-      const auto & weight = pair.first;
-      // get its level dimensionality if its nonzero and the U(3) weight is a U(3) irrep 
-      if (auto D_l = gen.getLevelDimensionality(weight)) 
-         // add contribution of this U(3) irrep to the sum
-         sum += D_l * dim(weight);
-   }
+   // iteration over resulting U(3) irreps and their level dimensionalities
+   for (const auto & pair : gen.getIrreps()) 
+      // add contribution of this U(3) irrep to the sum
+      sum += pair.second * dim(pair.first);
    std::cout << sum << std::endl;
 }
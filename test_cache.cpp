@@ -0,0 +1,153 @@
+// test_cache.cpp - a test driver for UNtoU3Cache class.
+//
+// License: BSD 2-Clause (https://opensource.org/licenses/BSD-2-Clause)
+//
+// Copyright (c) 2019, Daniel Langr
+// All rights reserved.
+//
+// Program stores tables of U(3) weights of a fixed set of input U(N) irreps into a cache directory, which is a new
+// temporary directory or the one given as the only command line argument, e.g.:
+//    ./test_cache /tmp/untou3_cache
+// Each table is mapped back from its file (by another instance of UNtoU3Cache) and compared with a freshly generated
+// one: multiplicities of all U(3) weights, level dimensionalities, and U(3) irreps. The table of the complement
+// of each irrep is derived from the cached one and compared as well. Files of the same table written twice need to be
+// identical byte by byte (also for types of labels and multiplicities with padding in entries of files), and a file
+// with a corrupted header needs to be rejected and replaced by a regenerated table.
+// The program prints the number of checked tables and fails if any check fails. Files in a temporary directory
+// are removed (together with the directory).
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#define UNTOU3_ENABLE_CACHE
+#include "UNtoU3.h"
+
+struct cache_case { int n; unsigned short n2, n1, n0; };
+
+// input irreps whose complements are not in the set
+const cache_case cases[] = { { 2, 1, 4, 1 }, { 3, 3, 4, 3 }, { 3, 6, 1, 3 }, { 4, 5, 6, 4 }, { 4, 9, 2, 4 } };
+
+void check(bool condition, const std::string& what) {
+   if (!condition) throw std::runtime_error("test_cache: " + what);
+}
+
+std::string read_file(const std::string& path) {
+   std::ifstream file(path, std::ios::binary);
+   check(file.good(), "cannot read " + path);
+   return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// compares the mapped table of cache with the table generated by gen
+template <typename T, typename U>
+void compare(const UNtoU3Cache<T, U>& cache, const UNtoU3<T, U>& gen, const std::string& what) {
+   std::map<std::array<T, 3>, U> expected, mapped;
+   for (const auto& pair : gen.multMap())
+      if (pair.second) expected[pair.first] = pair.second;
+   for (const auto& pair : cache.multMap()) mapped[pair.first] = pair.second;
+   check(mapped == expected, "multiplicities of " + what + " differ");
+
+   for (const auto& pair : expected)
+      check(cache.getLevelDimensionality(pair.first) == gen.getLevelDimensionality(pair.first),
+         "level dimensionalities of " + what + " differ");
+   const auto irreps = gen.getIrreps(), cached = cache.getIrreps();
+   check(std::map<std::array<T, 3>, U>(cached.begin(), cached.end()) == std::map<std::array<T, 3>, U>(irreps.begin(), irreps.end()),
+      "U(3) irreps of " + what + " differ");
+}
+
+// returns the number of checked tables, their files are removed if remove is true
+template <typename T, typename U>
+size_t run(const std::string& directory, bool remove) {
+   size_t tables = 0;
+   for (const auto& c : cases) {
+      const std::string what = "n = " + std::to_string(c.n) + ", [f] = [2^" + std::to_string(c.n2) + " 1^"
+         + std::to_string(c.n1) + " 0^" + std::to_string(c.n0) + "]";
+      UNtoU3<T, U> gen;
+      gen.generateXYZ(c.n);
+      gen.generateU3Weights(c.n2, c.n1, c.n0);
+
+      // the table is generated and written, then mapped by another instance
+      UNtoU3Cache<T, U> writer(directory);
+      writer.generateXYZ(c.n);
+      check(!writer.generateU3Weights(c.n2, c.n1, c.n0), "table of " + what + " is cached before it is written");
+      compare(writer, gen, what);
+      const std::string path = writer.path(c.n2, c.n1, c.n0);
+      const std::string bytes = read_file(path);
+
+      UNtoU3Cache<T, U> reader(directory);
+      reader.generateXYZ(c.n);
+      check(reader.generateU3Weights(c.n2, c.n1, c.n0), "table of " + what + " is not mapped from its file");
+      compare(reader, gen, what);
+      tables++;
+
+      // the same table is written into the same bytes
+      std::remove(path.c_str());
+      UNtoU3Cache<T, U> rewriter(directory);
+      rewriter.generateXYZ(c.n);
+      rewriter.generateU3Weights(c.n2, c.n1, c.n0);
+      check(read_file(path) == bytes, "files of the table of " + what + " differ");
+
+      // the complement is derived from the cached table
+      if (c.n2 != c.n0) {
+         gen.complement(c.n2, c.n1, c.n0);
+         check(reader.generateU3Weights(c.n0, c.n1, c.n2), "complement of " + what + " is not derived from its file");
+         compare(reader, gen, "the complement of " + what);
+         tables++;
+      }
+
+      // a file with a corrupted version is rejected (and replaced), the table can be derived from no complement 
+      if (c.n2 != c.n0) 
+         std::remove(writer.path(c.n0, c.n1, c.n2).c_str());
+      {
+         std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+         file.seekp(offsetof(untou3_cache_header, version));
+         const uint32_t version = untou3_cache_header::current_version + 1;
+         file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+         check(file.good(), "cannot corrupt " + path);
+      }
+      array_3_mapped_table<T, U> corrupted;
+      check(!corrupted.map(path, c.n, c.n2, c.n1, c.n0), "corrupted file of " + what + " is mapped");
+      gen.generateU3Weights(c.n2, c.n1, c.n0);
+      UNtoU3Cache<T, U> regenerator(directory);
+      regenerator.generateXYZ(c.n);
+      check(!regenerator.generateU3Weights(c.n2, c.n1, c.n0), "corrupted file of " + what + " is used");
+      compare(regenerator, gen, what);
+      check(read_file(path) == bytes, "regenerated file of the table of " + what + " differs");
+
+      if (remove)
+         std::remove(path.c_str());
+   }
+   return tables;
+}
+
+int main(int argc, char* argv[]) {
+   if (argc > 2)
+      throw std::invalid_argument("Usage: test_cache [directory]");
+   std::string directory;
+   const bool temporary = (argc < 2);
+   if (!temporary)
+      directory = argv[1];
+   else {
+      const char* tmp = std::getenv("TMPDIR");
+      std::string pattern = std::string(tmp ? tmp : "/tmp") + "/untou3_cache_XXXXXX";
+      std::vector<char> name(pattern.begin(), pattern.end());
+      name.push_back('\0');
+      check(mkdtemp(name.data()) != nullptr, "cannot create a temporary directory");
+      directory = name.data();
+   }
+
+   // tables of the same irreps with other types are stored in other files
+   size_t tables = run<uint32_t, uint32_t>(directory, temporary);
+   // (entries of files have padding bytes)
+   tables += run<uint8_t, uint32_t>(directory, temporary);
+   if (temporary)
+      rmdir(directory.c_str());
+   std::cout << "cached tables checked = " << tables << std::endl;
+}
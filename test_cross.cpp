@@ -0,0 +1,274 @@
+// test_cross.cpp - cross-validation and performance comparison of UNtoU3 against the original algorithm alg1.
+//
+// License: BSD 2-Clause (https://opensource.org/licenses/BSD-2-Clause)
+//
+// Copyright (c) 2019, Daniel Langr
+// All rights reserved.
+//
+// Program reduces input U(N) irreps [f] specified by the HO level n and the number of twos, ones, and zeros
+// (as in test_input) by GenerateU3Labels of alg1 and by UNtoU3::generateU3Weights with all its engines, and compares
+// the complete tables of U(3) weights and their multiplicities key by key. The cases are all irreps of HO levels
+// 0, ..., n_max (exhaustive) followed by a given number of random irreps of HO levels 1, ..., n_random (randomized),
+// which are specified by command line arguments (all are optional):
+//    ./test_cross [n_max [random_cases [n_random [seed [max_patterns]]]]]
+// Random irreps with more than max_patterns Gelfand patterns (dim[f]) are skipped, since alg1 enumerates them one
+// by one (10^7 by default).
+//
+// One line of comma-separated values is printed to the standard output for each case and engine (after a header line):
+// n, n2, n1, n0, engine, number of Gelfand patterns, table size (number of U(3) weights with nonzero multiplicities),
+// wall time of alg1 [s], wall time of UNtoU3 [s], and speedup of UNtoU3 over alg1. The first differences of tables
+// are printed to the standard error output, and the program fails if any tables differ.
+// With UNTOU3_ENABLE_OFFLOAD (test_cross_offload), the engines are run by the host, and the RECURSIVE engine is then 
+// run by the target device as well (engine OFFLOAD), so that tables of the device are checked against the same ones.
+// Each irrep is reduced also by UNtoU3Labels<2> (engine LABELS), whose tables and U(3) irreps need to be the same
+// as those of UNtoU3. Irreps with higher labels are then reduced by UNtoU3Labels<3> and UNtoU3Labels<4> (engines LABELS3
+// and LABELS4): all irreps of HO levels 0, ..., min(n_max, 2) followed by random irreps of HO levels 1, ..., n_random;
+// their column n2 contains the numbers of labels L, ..., 2 separated by slashes.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//#define UNTOU3_DISABLE_TCE
+//#define UNTOU3_DISABLE_UNORDERED
+//#define UNTOU3_ENABLE_DENSE
+//#define UNTOU3_DISABLE_PRECALC
+//#define UNTOU3_ENABLE_DOMINANT
+//#define UNTOU3_ENABLE_OPENMP
+//#define UNTOU3_ENABLE_OFFLOAD
+#include "UNtoU3.h"
+#include "alg1/alg1.h"
+
+struct cross_case { unsigned short n, n2, n1, n0; };
+
+// input irreps with labels 0, 1, ..., L (see UNtoU3Labels)
+template <int L>
+struct labels_case { unsigned short n; typename UNtoU3Labels<L>::GelfandRow f; };
+
+// U(3) weights and their nonzero multiplicities of both algorithms
+using cross_table = std::map<std::array<uint32_t, 3>, unsigned long long>;
+
+const UNtoU3<>::Engine engines[] =
+   { UNtoU3<>::Engine::RECURSIVE, UNtoU3<>::Engine::MEMOIZED, UNtoU3<>::Engine::GENERATING_FUNCTION };
+const char* const engine_names[] = { "RECURSIVE", "MEMOIZED", "GENERATING_FUNCTION" };
+
+template <typename Map>
+cross_table make_table(const Map& mult) {
+   cross_table table;
+   for (const auto& pair : mult) {
+#ifdef UNTOU3_ENABLE_DOMINANT
+      // (only these U(3) weights are recorded by UNtoU3)
+      const auto& w = pair.first;
+      if ((w[0] + 1 < w[1]) || (w[1] + 1 < w[2])) continue;
+#endif
+      if (pair.second)
+         table[{ (uint32_t)pair.first[0], (uint32_t)pair.first[1], (uint32_t)pair.first[2] }] += pair.second;
+   }
+   return table;
+}
+
+template <typename F>
+double wall_time(F f) {
+   const auto start = std::chrono::steady_clock::now();
+   f();
+   return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// prints (at most 10) differences of tables and returns their number
+size_t diff(const cross_table& alg1, const cross_table& untou3) {
+   size_t diffs = 0;
+   auto report = [&](const std::array<uint32_t, 3>& w, unsigned long long a, unsigned long long u) {
+      if (diffs++ < 10)
+         std::cerr << "   [" << w[0] << "," << w[1] << "," << w[2] << "] : alg1 " << a << ", UNtoU3 " << u << std::endl;
+   };
+   for (const auto& pair : alg1) {
+      const auto it = untou3.find(pair.first);
+      const unsigned long long u = (it == untou3.end()) ? 0 : it->second;
+      if (u != pair.second) report(pair.first, pair.second, u);
+   }
+   for (const auto& pair : untou3)
+      if (alg1.find(pair.first) == alg1.end()) report(pair.first, 0, pair.second);
+   return diffs;
+}
+
+// generates the table of alg1 for U(N) labels of [f] (in nonincreasing order) of the HO level n
+cross_table alg1_table(int n, const UN::LABELS& UNLabels, double& time) {
+   U3::SPS ShellSPS;
+   GenerateU3SPS(n, ShellSPS);
+   const uint32_t sumUNLabels = std::accumulate(UNLabels.begin(), UNLabels.end(), 0);
+   UN::U3MULT_LIST mult;
+   UN::BASIS_STATE_WEIGHT_VECTOR Weight(UNLabels.size());
+   time = wall_time([&] { GenerateU3Labels(UNLabels, sumUNLabels, ShellSPS, Weight, mult); });
+   return make_table(mult);
+}
+
+// prints the line of a case (its first four columns are given) and engine, returns false if tables differ
+bool compare(const std::string& columns, const std::string& what, const char* name, unsigned long long patterns,
+   const cross_table& alg1, double alg1_time, const cross_table& untou3, double time) {
+   std::cout << columns << "," << name << "," << patterns << "," << untou3.size() << "," << alg1_time << "," << time 
+      << "," << ((time > 0.0) ? alg1_time / time : 0.0) << std::endl;
+   if (untou3 == alg1) return true;
+   std::cerr << "Tables of U(3) weights differ for " << what << ", engine " << name << ":" << std::endl;
+   const size_t diffs = diff(alg1, untou3);
+   std::cerr << "   " << diffs << " U(3) weights differ" << std::endl;
+   return false;
+}
+
+// returns the number of engines whose tables differ from alg1 (or whose U(3) irreps differ from UNtoU3)
+size_t cross(const cross_case& c, unsigned long long max_patterns) {
+   // number of Gelfand patterns enumerated by alg1 
+   const std::string dim = UNtoU3<>::dimension(c.n2, c.n1, c.n0).str();
+   if ((dim.size() > 19) || (std::stoull(dim) > max_patterns)) return 0;
+   const unsigned long long patterns = std::stoull(dim);
+
+   UN::LABELS UNLabels(c.n2, 2);
+   UNLabels.insert(UNLabels.end(), c.n1, 1);
+   UNLabels.insert(UNLabels.end(), c.n0, 0);
+   double alg1_time;
+   const cross_table alg1 = alg1_table(c.n, UNLabels, alg1_time);
+   const std::string columns = std::to_string(c.n) + "," + std::to_string(c.n2) + "," + std::to_string(c.n1) + ","
+      + std::to_string(c.n0);
+   const std::string what = "n = " + std::to_string(c.n) + ", [f] = [2^" + std::to_string(c.n2) + " 1^" 
+      + std::to_string(c.n1) + " 0^" + std::to_string(c.n0) + "]";
+
+   UNtoU3<> gen;
+   gen.generateXYZ(c.n);
+#ifdef UNTOU3_ENABLE_OFFLOAD
+   // engines are run by the host first
+   gen.setOffload(-1);
+#endif
+   size_t failed = 0;
+   auto check = [&](const char* name, UNtoU3<>::Engine engine) {
+      const double time = wall_time([&] { gen.generateU3Weights(c.n2, c.n1, c.n0, engine); });
+      if (!compare(columns, what, name, patterns, alg1, alg1_time, make_table(gen.multMap()), time)) failed++;
+   };
+   for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++) 
+      check(engine_names[e], engines[e]);
+#ifdef UNTOU3_ENABLE_OFFLOAD
+   // the RECURSIVE engine by the device, or by the device code on the host (initial device) if no device is available;
+   // all trees are offloaded
+   gen.setOffload((omp_get_num_devices() > 0) ? omp_get_default_device() : omp_get_initial_device(), 1);
+   check("OFFLOAD", UNtoU3<>::Engine::RECURSIVE);
+#endif
+
+   // UNtoU3Labels reproduces UNtoU3 for labels {2,1,0}
+   UNtoU3Labels<2> labels;
+   labels.generateXYZ(c.n);
+   const double time = wall_time([&] { labels.generateU3Weights({ c.n2, c.n1, c.n0 }); });
+   if (!compare(columns, what, "LABELS", patterns, alg1, alg1_time, make_table(labels.multMap()), time)) failed++;
+   const auto irreps = gen.getIrreps(), labels_irreps = labels.getIrreps();
+   using irrep_table = std::map<UNtoU3<>::U3Weight, uint32_t>;
+   if (irrep_table(labels_irreps.begin(), labels_irreps.end()) != irrep_table(irreps.begin(), irreps.end())) {
+      std::cerr << "U(3) irreps of UNtoU3Labels<2> and UNtoU3 differ for " << what << std::endl;
+      failed++;
+   }
+   return failed;
+}
+
+// returns 1 if the table of UNtoU3Labels<L> differs from alg1
+template <int L>
+size_t cross_labels(const labels_case<L>& c, unsigned long long max_patterns) {
+   // (dim[f] by the Weyl dimension formula)
+   const long double dim = UNtoU3Labels<L>::maxMultiplicity(c.f);
+   if (dim > (long double)max_patterns) return 0;
+   const unsigned long long patterns = (unsigned long long)dim;
+
+   UN::LABELS UNLabels;
+   std::string columns = std::to_string(c.n) + ",", what = "n = " + std::to_string(c.n) + ", [f] = [";
+   for (int j = 0; j <= L; j++) {
+      UNLabels.insert(UNLabels.end(), c.f[j], L - j);
+      columns += std::to_string(c.f[j]) + ((j < L - 2) ? "/" : ((j < L) ? "," : ""));
+      what += std::to_string(L - j) + "^" + std::to_string(c.f[j]) + ((j < L) ? " " : "]");
+   }
+   double alg1_time;
+   const cross_table alg1 = alg1_table(c.n, UNLabels, alg1_time);
+
+   UNtoU3Labels<L> gen;
+   gen.generateXYZ(c.n);
+   const double time = wall_time([&] { gen.generateU3Weights(c.f); });
+   const std::string name = "LABELS" + std::to_string(L);
+   return compare(columns, what, name.c_str(), patterns, alg1, alg1_time, make_table(gen.multMap()), time) ? 0 : 1;
+}
+
+// all irreps of HO levels 0, ..., n_max followed by random irreps of HO levels 1, ..., n_random
+template <int L>
+std::vector<labels_case<L>> labels_cases(int n_max, int random_cases, int n_random, std::mt19937& rng) {
+   std::vector<labels_case<L>> cases;
+   // numbers of labels L, ..., 1 of a HO level with N labels, incremented as digits of an odometer
+   auto add = [&](int n) {
+      const int N = (n + 1) * (n + 2) / 2;
+      labels_case<L> c{ (unsigned short)n, {} };
+      while (true) {
+         int sum = 0;
+         for (int j = 0; j < L; j++) sum += c.f[j];
+         if (sum <= N) {
+            c.f[L] = (uint16_t)(N - sum);
+            cases.push_back(c);
+         }
+         int j = L - 1;
+         while ((j >= 0) && (c.f[j] == N)) c.f[j--] = 0;
+         if (j < 0) break;
+         c.f[j]++;
+      }
+   };
+   for (int n = 0; n <= n_max; n++) add(n);
+   for (int i = 0; i < random_cases; i++) {
+      const int n = std::uniform_int_distribution<int>(1, n_random)(rng);
+      int N = (n + 1) * (n + 2) / 2;
+      labels_case<L> c{ (unsigned short)n, {} };
+      for (int j = 0; j < L; j++) {
+         c.f[j] = (uint16_t)std::uniform_int_distribution<int>(0, N)(rng);
+         N -= c.f[j];
+      }
+      c.f[L] = (uint16_t)N;
+      cases.push_back(c);
+   }
+   return cases;
+}
+
+int main(int argc, char* argv[]) {
+   if (argc > 6)
+      throw std::invalid_argument("Usage: test_cross [n_max [random_cases [n_random [seed [max_patterns]]]]]");
+   const int n_max = (argc > 1) ? std::atoi(argv[1]) : 3;
+   const int random_cases = (argc > 2) ? std::atoi(argv[2]) : 20;
+   const int n_random = (argc > 3) ? std::atoi(argv[3]) : 5;
+   const unsigned long seed = (argc > 4) ? std::strtoul(argv[4], nullptr, 10) : 2019;
+   const unsigned long long max_patterns = (argc > 5) ? std::strtoull(argv[5], nullptr, 10) : 10000000;
+   if ((n_max < 0) || (random_cases < 0) || (n_random < 1))
+      throw std::invalid_argument("Arguments mismatch!");
+
+   std::vector<cross_case> cases;
+   for (int n = 0; n <= n_max; n++) {
+      const int N = (n + 1) * (n + 2) / 2;
+      for (int n2 = 0; n2 <= N; n2++)
+         for (int n1 = 0; n2 + n1 <= N; n1++)
+            cases.push_back({ (unsigned short)n, (unsigned short)n2, (unsigned short)n1, (unsigned short)(N - n2 - n1) });
+   }
+   std::mt19937 rng(seed);
+   for (int i = 0; i < random_cases; i++) {
+      const int n = std::uniform_int_distribution<int>(1, n_random)(rng);
+      const int N = (n + 1) * (n + 2) / 2;
+      const int n2 = std::uniform_int_distribution<int>(0, N)(rng);
+      const int n1 = std::uniform_int_distribution<int>(0, N - n2)(rng);
+      cases.push_back({ (unsigned short)n, (unsigned short)n2, (unsigned short)n1, (unsigned short)(N - n2 - n1) });
+   }
+
+   std::cout << "n,n2,n1,n0,engine,patterns,table_size,alg1_s,untou3_s,speedup" << std::endl;
+   size_t failed = 0;
+   for (const auto& c : cases)
+      failed += cross(c, max_patterns);
+   // irreps with higher labels
+   for (const auto& c : labels_cases<3>(std::min(n_max, 2), random_cases, n_random, rng))
+      failed += cross_labels(c, max_patterns);
+   for (const auto& c : labels_cases<4>(std::min(n_max, 2), random_cases, n_random, rng))
+      failed += cross_labels(c, max_patterns);
+   if (failed > 0)
+      throw std::runtime_error("Tables of U(3) weights of UNtoU3 and alg1 differ!");
+}
@@ -14,48 +14,35 @@
 // of resulting U(3) irrpes multiplied by their level dimensionalities, and print it to the
 // standard output. For instance, for the input irrep specified above, the output should read:
 // U(3) irreps total dim = 2168999910
+// The same sum is then evaluated by streaming U(3) weights into untou3_irrep_sink without a table of weights,
+// and the program fails if the sums differ. It fails as well if U(3) irreps generated by the GENERATING_FUNCTION
+// engine or level dimensionalities looked up in the finalized table differ, or if the table of the complement
+// of [f] derived from its table does not match dim[f].
 //
-// This sum should be equal to dim[f], which can be calculated analytically with the support 
-// of rational numbers. The program performs this calculcation as well if the Boost library 
-// is available and uses its Boost.Rational sublibrary. Availabitliy of Boost is indicated by
-// users by definition of HAVE_BOOST preprocessor symbol. 
-// For the input irrep [f] specified above, the program should first print out:
+// This sum should be equal to dim[f], which is calculated analytically in exact integer arithmetic 
+// by UNtoU3::dimension. For the input irrep [f] specified above, the program should first print out:
 // U(N) irrep dim = 2168999910
+// The finalized table is then validated against dim[f] (see UNtoU3::validate), which is exact even if 
+// the sum of dimensions overflows unsigned long.
 
-#include <algorithm>
-#include <cassert>
 #include <iostream>
-#include <iterator>
+#include <limits>
 #include <stdexcept>
-#include <vector>
-
-#ifdef HAVE_BOOST
-#include <boost/rational.hpp>
-#endif
+#include <string>
 
 //#define UNTOU3_DISABLE_TCE
 //#define UNTOU3_DISABLE_UNORDERED
+//#define UNTOU3_ENABLE_DENSE
 //#define UNTOU3_DISABLE_PRECALC
+//#define UNTOU3_ENABLE_THREADS
+//#define UNTOU3_ENABLE_OVERFLOW_CHECK
+//#define UNTOU3_ENABLE_OFFLOAD
+//#define UNTOU3_ENABLE_STATS
+//#define UNTOU3_ENABLE_DOMINANT
+//#define UNTOU3_ENABLE_NUMA
 #define UNTOU3_ENABLE_OPENMP
 #include "UNtoU3.h"
 
-#ifdef HAVE_BOOST
-// Impelments analytical formula for calculation of a dimension of a generic U(N) irrep [f].
-// [f] is specified by its labels passed as an array (generaly any indexed data structure)
-// argument irrep.
-template <typename T>
-unsigned long dim(const T & irrep) {
-   const auto N = irrep.size();
-   boost::rational<unsigned long> result{1};
-   for (uint32_t l = 2; l <= N; l++)
-      for (uint32_t k = 1; k <= l - 1; k++)
-         result *= { irrep[k - 1] - irrep[l - 1] + l - k, l - k };
-
-   assert(result.denominator() == 1);
-   return result.numerator();
-}
-#endif
-
 // Implements analytical formula for calculcation of a dimension of an input U(3) irrep.
 // (Does not require rational arithmetics.)
 unsigned long dim(const UNtoU3<>::U3Weight & irrep) {
@@ -72,29 +59,85 @@ int main() {
    if (n2 + n1 + n0 != (n + 1) * (n + 2) / 2)
       throw std::invalid_argument("Arguments mismatch!");
 
-#ifdef HAVE_BOOST
    // analytical calculation of dim([f])
-   std::vector<unsigned long> f(n2, 2);
-   std::fill_n(std::back_inserter(f), n1, 1);
-   std::fill_n(std::back_inserter(f), n0, 0);
-   std::cout << "U(N) irrep dim = " << dim(f) << std::endl;
-#endif
+   std::cout << "U(N) irrep dim = " << UNtoU3<>::dimension(n2, n1, n0) << std::endl;
 
    UNtoU3<> gen;
+#ifdef UNTOU3_ENABLE_THREADS
+   // parallel generation by std::threads instead of OpenMP
+   untou3_thread_executor executor;
+   gen.setExecutor(&executor);
+#endif
    // generate HO vectors for a given n
    gen.generateXYZ(n);
    // generation of U(3) irreps in the input U(N) irrep [f]
+#ifdef UNTOU3_ENABLE_THREADS
+   // (asynchronously, the calling thread only waits for the table)
+   gen.generateU3WeightsAsync(n2, n1, n0).get();
+#else
    gen.generateU3Weights(n2, n1, n0);
+#endif
+#ifdef UNTOU3_ENABLE_STATS
+   // where the time of generation went
+   const auto & stats = gen.stats();
+   std::cout << "Gelfand patterns = " << stats.patterns << ", rows = " << stats.rows << ", tasks spawned = " << stats.tasks_spawned 
+      << ", inlined = " << stats.tasks_inlined << ", rehashes = " << stats.rehashes << ", table size = " << stats.table_size << std::endl;
+   std::cout << "leaf hits by levels:";
+   for (auto hits : stats.leaf_hits) std::cout << " " << hits;
+   std::cout << std::endl << "busy / merge time [s] of threads:";
+   for (size_t t = 0; t < stats.busy_time.size(); t++) std::cout << " " << stats.busy_time[t] << " / " << stats.merge_time[t];
+   std::cout << std::endl;
+
+   // statistics of generators of the same thread are independent, also of a destroyed one
+   const auto patterns = stats.patterns;
+   {
+      UNtoU3<> other;
+      other.generateXYZ(2);
+      other.generateU3Weights(1, 4, 1);
+   }
+   UNtoU3Fixed<2> fixed;
+   fixed.generateU3Weights(1, 4, 1);
+   if ((std::to_string(fixed.stats().patterns) != UNtoU3<>::dimension(1, 4, 1).str()) || (gen.stats().patterns != patterns))
+      throw std::runtime_error("Statistics of generators are mixed up!");
+#endif
    // calculated sum
    unsigned long sum = 0;
-   // iteration over generated U(3) weights
-   for (const auto & pair : gen.multMap()) {
-      // get U(3) weight lables
-      const auto & weight = pair.first;
-      // get its level dimensionality if its nonzero and the U(3) weight is a U(3) irrep 
-      if (auto D_l = gen.getLevelDimensionality(weight)) 
-         // add contribution of this U(3) irrep to the sum
-         sum += D_l * dim(weight);
+   // iteration over resulting U(3) irreps and their level dimensionalities
+   for (const auto & pair : gen.getIrreps()) {
+      // add contribution of this U(3) irrep to the sum
+      const unsigned long D_l = pair.second, d = dim(pair.first);
+      if (D_l > (std::numeric_limits<unsigned long>::max() - sum) / d)
+         throw std::overflow_error("Sum of U(3) irreps dimensions overflows!");
+      sum += D_l * d;
    }
    std::cout << "U(3) irreps total dim = " << sum << std::endl;
+
+   // level dimensionalities looked up in the index of U(3) irreps, the table is validated exactly by the same pass
+   gen.finalize();
+   gen.validate(n2, n1, n0);
+   for (const auto & pair : gen.getIrreps())
+      if (gen.getLevelDimensionality(pair.first) != pair.second)
+         throw std::runtime_error("Level dimensionalities of the finalized table differ!");
+
+   // the same sum evaluated from contributions of streamed U(3) weights 
+   // (partial sums may wrap around, the final one is exact in the modular arithmetic of unsigned long)
+   unsigned long streamed = 0;
+   gen.generateU3Weights(n2, n1, n0, untou3_make_irrep_sink(
+      [&](const UNtoU3<>::U3Weight & irrep, uint32_t count, int sign) {
+         const unsigned long c = (unsigned long)count * dim(irrep);
+         streamed += (sign > 0) ? c : -c;
+      }));
+   if (streamed != sum)
+      throw std::runtime_error("Streamed sum of U(3) irreps dimensions differs!");
+
+   // U(3) irreps generated by the generating function of [f] without enumeration of Gelfand patterns
+   const auto irreps = gen.getIrreps();
+   gen.generateU3Weights(n2, n1, n0, UNtoU3<>::Engine::GENERATING_FUNCTION);
+   if (gen.getIrreps() != irreps)
+      throw std::runtime_error("U(3) irreps of the GENERATING_FUNCTION engine differ!");
+
+   // the table of the complement [2^n0 1^n1 0^n2] derived from the table of [f] 
+   gen.complement(n2, n1, n0);
+   gen.finalize();
+   gen.validate(n0, n1, n2);
 }
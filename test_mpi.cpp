@@ -0,0 +1,79 @@
+// test_mpi.cpp - a scaling test driver for UNtoU3 class distributed over MPI ranks.
+// 
+// License: BSD 2-Clause (https://opensource.org/licenses/BSD-2-Clause)
+//
+// Copyright (c) 2019, Daniel Langr
+// All rights reserved.
+//
+// Program implements the U(N) to U(3) reduction of the input irrep [f] specified by the HO level n, N=(n+1)*(n+2)/2, 
+// and its number of twos, ones, and zeros read from the standard input by rank 0 (in the same way as test_input).
+// For instance, for the input U(21) irrep [f] = [2,2,2,2,2,2,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0],
+// the user should provide the following numbers: 5 6 1 14.
+//
+// U(3) weights are generated by all ranks of MPI_COMM_WORLD, each of them uses OpenMP threads for its share
+// of Gelfand patterns. Rank 0 then prints the sum of the dimensions of resulting U(3) irreps multiplied by their 
+// level dimensionalities as test_input does, and the time of generation together with the numbers of ranks and threads:
+// U(3) irreps total dim = 2168999910
+// ranks = 4, threads per rank = 8, generation time [s] = ...
+// Scaling is evaluated by running the program with different numbers of ranks, e.g.:
+//    echo "5 6 1 14" | mpirun -np 4 ./test_mpi
+
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+//#define UNTOU3_ENABLE_DENSE
+#define UNTOU3_ENABLE_OPENMP
+#define UNTOU3_ENABLE_MPI
+#include "UNtoU3.h"
+
+// Implements analytical formula for calculcation of a dimension of an input U(3) irrep.
+unsigned long dim(const UNtoU3<>::U3Weight & irrep) {
+   return (irrep[0] - irrep[1] + 1) * (irrep[0] - irrep[2] + 2) * (irrep[1] - irrep[2] + 1) / 2;
+}
+
+int main(int argc, char* argv[]) {
+   // MPI is called only outside of OpenMP parallel regions
+   int provided;
+   MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+   int rank, size;
+   MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+   MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+   // HO level and specification of intput U(N) irrep
+   unsigned long input[4] = { 0, 0, 0, 0 };
+   if (rank == 0) 
+      std::cin >> input[0] >> input[1] >> input[2] >> input[3];
+   MPI_Bcast(input, 4, MPI_UNSIGNED_LONG, 0, MPI_COMM_WORLD);
+   const unsigned long n = input[0];
+   const unsigned short n2 = input[1], n1 = input[2], n0 = input[3];
+
+   if (n2 + n1 + n0 != (n + 1) * (n + 2) / 2)
+      throw std::invalid_argument("Arguments mismatch!");
+
+   UNtoU3<> gen;
+   gen.setCommunicator(MPI_COMM_WORLD);
+   // generate HO vectors for a given n
+   gen.generateXYZ(n);
+   // generation of U(3) irreps in the input U(N) irrep [f] by all ranks
+   MPI_Barrier(MPI_COMM_WORLD);
+   double start = MPI_Wtime();
+   gen.generateU3Weights(n2, n1, n0);
+   double time = MPI_Wtime() - start;
+
+   if (rank == 0) {
+      // calculated sum
+      unsigned long sum = 0;
+      for (const auto & pair : gen.getIrreps()) {
+         const unsigned long D_l = pair.second, d = dim(pair.first);
+         if (D_l > (std::numeric_limits<unsigned long>::max() - sum) / d)
+            throw std::overflow_error("Sum of U(3) irreps dimensions overflows!");
+         sum += D_l * d;
+      }
+      std::cout << "U(3) irreps total dim = " << sum << std::endl;
+      std::cout << "ranks = " << size << ", threads per rank = " << omp_get_max_threads() 
+         << ", generation time [s] = " << time << std::endl;
+   }
+
+   MPI_Finalize();
+}